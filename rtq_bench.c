@@ -0,0 +1,394 @@
+/* Microbenchmarks of the rtqueue primitives, outside of the consume_us()
+   spinning and clock_nanosleep() pacing of the -o mode.
+
+   Scenarios (all at every fill level 1, 2, 4, ..., MAX_SIZE unless noted):
+     push_pop      rtq_push() + rtq_pop() pair, single thread
+     popn          rtq_popn_nosync() of the middle element (+ re-insertion)
+     pop_dl_first  rtq_pop_dl_nosync() when the oldest job is feasible
+     pop_dl_scan   rtq_pop_dl_nosync() when no job is feasible (full scan)
+                   (both on a fixed reservation state, see bench_dl_begin())
+     budget        budget_to_deadline(), both branches (no fill level)
+     mt_pair       T threads, each doing rtq_push() then rtq_pop()
+     mt_prodcons   T/2 producers on rtq_push(), T/2 consumers on rtq_pop()
+     mt_jobs       as mt_prodcons, producers filling the job fields before
+                   the push and consumers writing elapsed_us after the pop,
+                   as the generator and the workers do
+
+   Every measurement is a batch of -k operations timed as a whole; after
+   -w warm-up batches, -r batches give the median, MAD, min and max of the
+   per-operation cost, written as JSON. */
+
+#define RTQ_NO_MAIN
+#include "rtqueue.c"
+
+int bench_reps = 31;
+int bench_warmup = 5;
+int bench_batch = 1000;
+int bench_max_threads = 8;
+
+/* Robust summary of the per-operation cost of bench_reps batches */
+typedef struct {
+  double median;
+  double mad;
+  double min;
+  double max;
+} bench_summary_t;
+
+int bench_cmp_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+double bench_median_sorted(const double *v, int n) {
+  return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+bench_summary_t bench_summarize(double *v, int n) {
+  bench_summary_t s;
+  qsort(v, n, sizeof(double), bench_cmp_double);
+  s.median = bench_median_sorted(v, n);
+  s.min = v[0];
+  s.max = v[n - 1];
+  double dev[n];
+  for (int i = 0; i < n; i++)
+    dev[i] = fabs(v[i] - s.median);
+  qsort(dev, n, sizeof(double), bench_cmp_double);
+  s.mad = bench_median_sorted(dev, n);
+  return s;
+}
+
+long bench_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts_to_ns(ts);
+}
+
+/* Bench-only unlocked push, used to restore the fill level after a pop
+   without counting the mutex or the RED drop policy */
+void bench_push_nosync(rtqueue_t *pq, job_t *p_elem) {
+  pq->elems[pq->head] = p_elem;
+  pq->head = (pq->head + 1) % MAX_SIZE;
+  pq->size++;
+}
+
+void bench_fill(rtqueue_t *pq, int fill) {
+  pq->head = pq->tail = pq->size = 0;
+  for (int i = 0; i < fill; i++)
+    bench_push_nosync(pq, &jobs[i]);
+}
+
+FILE *bench_out;
+int bench_first_result = 1;
+
+void bench_emit(const char *op, const char *pattern, int fill, int threads, bench_summary_t s, double extra, const char *extra_name) {
+  fprintf(bench_out, "%s\n    {\"op\": \"%s\", \"pattern\": \"%s\", \"fill\": %d, \"threads\": %d, "
+          "\"ns_per_op\": {\"median\": %.2f, \"mad\": %.2f, \"min\": %.2f, \"max\": %.2f}",
+          bench_first_result ? "" : ",", op, pattern, fill, threads, s.median, s.mad, s.min, s.max);
+  if (extra_name != NULL)
+    fprintf(bench_out, ", \"%s\": %.4f", extra_name, extra);
+  fprintf(bench_out, "}");
+  bench_first_result = 0;
+}
+
+/* Runs fn(fill) bench_warmup + bench_reps times; fn returns the elapsed ns
+   of one batch of bench_batch operations */
+bench_summary_t run_reps(long (*fn)(int), int fill) {
+  double v[bench_reps];
+  for (int i = 0; i < bench_warmup; i++)
+    fn(fill);
+  for (int i = 0; i < bench_reps; i++)
+    v[i] = fn(fill) / (double)bench_batch;
+  return bench_summarize(v, bench_reps);
+}
+
+long batch_push_pop(int fill) {
+  bench_fill(&q, fill - 1);
+  long t0 = bench_now_ns();
+  for (int i = 0; i < bench_batch; i++) {
+    check(rtq_push(&q, &jobs[MAX_SIZE + (i & 1023)]));
+    check(rtq_pop(&q, 0) != NULL);
+  }
+  return bench_now_ns() - t0;
+}
+
+long batch_popn(int fill) {
+  bench_fill(&q, fill);
+  int n = fill / 2;
+  long t0 = bench_now_ns();
+  for (int i = 0; i < bench_batch; i++) {
+    job_t *p_job = rtq_popn_nosync(&q, n);
+    bench_push_nosync(&q, p_job);
+  }
+  return bench_now_ns() - t0;
+}
+
+long pop_dl_accepted;
+
+long batch_pop_dl(int fill) {
+  bench_fill(&q, fill);
+  long t0 = bench_now_ns();
+  for (int i = 0; i < bench_batch; i++) {
+    job_t *p_job = rtq_pop_dl_nosync(&q);
+    if (p_job != NULL) {
+      pop_dl_accepted++;
+      bench_push_nosync(&q, p_job);
+    }
+  }
+  return bench_now_ns() - t0;
+}
+
+#define BUDGET_INPUTS 1024
+long budget_in[BUDGET_INPUTS][3];
+volatile long budget_sink;
+
+long batch_budget(int fill) {
+  (void)fill;
+  long acc = 0;
+  long t0 = bench_now_ns();
+  for (int i = 0; i < bench_batch; i++) {
+    long *in = budget_in[i % BUDGET_INPUTS];
+    acc += budget_to_deadline(in[0], in[1], in[2]);
+  }
+  long t1 = bench_now_ns();
+  budget_sink = acc;
+  return t1 - t0;
+}
+
+/* The bench thread has no SCHED_DEADLINE reservation to query: the
+   rtq_pop_dl_nosync() and budget scenarios read instead the fixed CBS state
+   of a 10ms/100ms reservation through the --virtual model, with the whole
+   runtime left and the current period ending in 50ms, at a frozen now */
+vworker_t bench_vw;
+
+static void bench_dl_begin(void) {
+  struct timespec ts_now;
+  clock_gettime(CLOCK_MONOTONIC, &ts_now);
+  dl_runtime_us = 10000;
+  dl_period_us = 100000;
+  u_tot = 0.1;
+  vt_now_ns = ts_to_ns(ts_now);
+  bench_vw.runtime_left_ns = dl_runtime_us * 1000l;
+  bench_vw.abs_deadline_ns = vt_now_ns + 50000000l;
+  vt_cur = &bench_vw;
+  virtual_time = 1;
+}
+
+static void bench_dl_end(void) {
+  virtual_time = 0;
+  vt_cur = NULL;
+  dl_runtime_us = 0;
+  dl_period_us = 0;
+}
+
+/* Multi-threaded scenarios: each rep releases all threads on a barrier and
+   times the rep from the main thread until the last one is done */
+typedef struct {
+  pthread_t pthr;
+  int id;
+  int role;      // 0: push then pop, 1: producer, 2: consumer
+  int touch;     // write the job fields around push and pop
+  int ops;
+} bench_thread_t;
+
+pthread_barrier_t bench_start, bench_end;
+int bench_quit = 0;
+
+void *bench_thread(void *arg) {
+  bench_thread_t *t = arg;
+  for (;;) {
+    pthread_barrier_wait(&bench_start);
+    if (bench_quit)
+      break;
+    for (int i = 0; i < t->ops; i++) {
+      job_t *p_job = &jobs[MAX_SIZE + t->id * 1024 + (i & 1023)];
+      if (t->role != 2) {
+        if (t->touch) {
+          clock_gettime(CLOCK_MONOTONIC, &p_job->sent);
+          p_job->deadline_ts = p_job->sent;
+          p_job->C_us = i;
+        }
+        while (!rtq_push(&q, p_job))
+          sched_yield();
+      }
+      if (t->role != 1) {
+        job_t *p = rtq_pop(&q, 0);
+        check(p != NULL);
+        if (t->touch)
+          p->elapsed_us = p->C_us + 1;
+      }
+    }
+    pthread_barrier_wait(&bench_end);
+  }
+  return NULL;
+}
+
+/* ns per operation of all threads together (wall time / total ops) */
+bench_summary_t run_mt(int nthr, int prodcons, int touch) {
+  bench_thread_t thr[nthr];
+  pthread_barrier_init(&bench_start, NULL, nthr + 1);
+  pthread_barrier_init(&bench_end, NULL, nthr + 1);
+  bench_quit = 0;
+  for (int i = 0; i < nthr; i++) {
+    thr[i].id = i;
+    thr[i].role = prodcons ? 1 + i % 2 : 0;
+    thr[i].touch = touch;
+    thr[i].ops = bench_batch;
+    pthread_create(&thr[i].pthr, NULL, &bench_thread, &thr[i]);
+  }
+
+  double v[bench_reps];
+  for (int i = 0; i < bench_warmup + bench_reps; i++) {
+    bench_fill(&q, 0);
+    long t0 = bench_now_ns();
+    pthread_barrier_wait(&bench_start);
+    pthread_barrier_wait(&bench_end);
+    long t1 = bench_now_ns();
+    if (i >= bench_warmup)
+      v[i - bench_warmup] = (t1 - t0) / (double)(nthr * bench_batch);
+  }
+
+  bench_quit = 1;
+  pthread_barrier_wait(&bench_start);
+  for (int i = 0; i < nthr; i++)
+    pthread_join(thr[i].pthr, NULL);
+  pthread_barrier_destroy(&bench_start);
+  pthread_barrier_destroy(&bench_end);
+  return bench_summarize(v, bench_reps);
+}
+
+/* rtq_push() and rtq_pop_dl_nosync() read the published knobs, not the
+   globals: publish them again after changing any */
+static void bench_publish_knobs(void) {
+  knobs_t k = { push_drop_size, red_min_th, red_max_th, red_max_p,
+                comp_time_perc_us, prob_dismiss_wcet_us };
+  knobs_publish(&k);
+}
+
+int main(int argc, char *argv[]) {
+  char *out_path = NULL;
+
+  argc--;  argv++;
+  while (argc > 0) {
+    if (strcmp(*argv, "-h") == 0 || strcmp(*argv, "--help") == 0) {
+      printf("Usage: rtq_bench [-h|--help] [-r|--reps n] [-w|--warmup n] [-k|--batch ops] [-T|--max-threads n] [-a|--set-affinity cpu] [-dlp|--dl-params auto|getattr|kmod|proc] [--json file]\n");
+      exit(EXIT_SUCCESS);
+    } else if (strcmp(*argv, "-r") == 0 || strcmp(*argv, "--reps") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      check(sscanf(*argv, "%d", &bench_reps) == 1 && bench_reps > 0);
+    } else if (strcmp(*argv, "-w") == 0 || strcmp(*argv, "--warmup") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      check(sscanf(*argv, "%d", &bench_warmup) == 1 && bench_warmup >= 0);
+    } else if (strcmp(*argv, "-k") == 0 || strcmp(*argv, "--batch") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      check(sscanf(*argv, "%d", &bench_batch) == 1 && bench_batch > 0);
+    } else if (strcmp(*argv, "-T") == 0 || strcmp(*argv, "--max-threads") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      check(sscanf(*argv, "%d", &bench_max_threads) == 1);
+      check(bench_max_threads > 0 && (bench_max_threads + 1) * 1024 + MAX_SIZE <= MAX_NUM_REQS);
+    } else if (strcmp(*argv, "-a") == 0 || strcmp(*argv, "--set-affinity") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      check(sscanf(*argv, "%d", &affinity_cpu) == 1);
+    } else if (strcmp(*argv, "-dlp") == 0 || strcmp(*argv, "--dl-params") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      if (strcmp(*argv, "auto") == 0)
+        dlpar_type = DL_PARAMS_AUTO;
+      else if (strcmp(*argv, "getattr") == 0)
+        dlpar_type = DL_PARAMS_GETATTR;
+      else if (strcmp(*argv, "kmod") == 0)
+        dlpar_type = DL_PARAMS_KMOD;
+      else if (strcmp(*argv, "proc") == 0)
+        dlpar_type = DL_PARAMS_PROC;
+      else {
+        fprintf(stderr, "Wrong argument to -dlp|--dl-params option: %s\n", argv[0]);
+        exit(1);
+      }
+    } else if (strcmp(*argv, "--json") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      out_path = *argv;
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", *argv);
+      exit(1);
+    }
+    argc--;  argv++;
+  }
+
+  bench_out = stdout;
+  if (out_path != NULL) {
+    bench_out = fopen(out_path, "w");
+    check(bench_out != NULL, "fopen() of json file failed");
+  }
+
+  check(dl_params_init(dlpar_type) == 0, "dl_params_init() failed!");
+  if (affinity_cpu != -1)
+    set_affinity(affinity_cpu);
+
+  rtq_init(&q);
+  bench_publish_knobs();
+  srand(1);
+
+  // jobs due in one minute: never dropped as late during the bench
+  struct timespec ts_now;
+  clock_gettime(CLOCK_MONOTONIC, &ts_now);
+  for (int j = 0; j < MAX_NUM_REQS; j++) {
+    jobs[j].sent = ts_now;
+    jobs[j].deadline_ts = ts_now;
+    ts_add_us(&jobs[j].deadline_ts, 60 * 1000000.0);
+    jobs[j].C_us = 1000;
+  }
+
+  // budget_to_deadline() inputs covering both branches
+  bench_dl_begin();
+  for (int i = 0; i < BUDGET_INPUTS; i++) {
+    budget_in[i][0] = rand() % (dl_runtime_us * 1000);
+    budget_in[i][1] = rand() % (dl_period_us * 1000);
+    budget_in[i][2] = rand() % (4 * dl_period_us * 1000);
+  }
+
+  fprintf(bench_out, "{\n  \"bench\": \"rtqueue\", \"max_size\": %d, \"reps\": %d, \"warmup\": %d, \"batch\": %d, \"dlparams\": \"%s\",\n  \"results\": [",
+          MAX_SIZE, bench_reps, bench_warmup, bench_batch, dl_params_str());
+
+  for (int fill = 1; fill <= MAX_SIZE; fill *= 2) {
+    bench_emit("push_pop", "single", fill, 1, run_reps(batch_push_pop, fill), 0, NULL);
+    bench_emit("popn", "single", fill, 1, run_reps(batch_popn, fill), 0, NULL);
+
+    // C_us = 0: the first job fits; huge C_us: no job fits, all are scanned
+    comp_time_perc_us = 0;
+    bench_publish_knobs();
+    pop_dl_accepted = 0;
+    bench_summary_t s = run_reps(batch_pop_dl, fill);
+    bench_emit("pop_dl_first", "single", fill, 1, s,
+         pop_dl_accepted / (double)((bench_warmup + bench_reps) * bench_batch), "accepted_frac");
+
+    comp_time_perc_us = 1e9;
+    bench_publish_knobs();
+    pop_dl_accepted = 0;
+    s = run_reps(batch_pop_dl, fill);
+    bench_emit("pop_dl_scan", "single", fill, 1, s,
+         pop_dl_accepted / (double)((bench_warmup + bench_reps) * bench_batch), "accepted_frac");
+  }
+
+  bench_emit("budget", "single", 0, 1, run_reps(batch_budget, 0), 0, NULL);
+  bench_dl_end();
+
+  for (int t = 1; t <= bench_max_threads; t *= 2)
+    bench_emit("push_pop", "mt_pair", 0, t, run_mt(t, 0, 0), 0, NULL);
+  for (int t = 2; t <= bench_max_threads; t *= 2)
+    bench_emit("push_pop", "mt_prodcons", 0, t, run_mt(t, 1, 0), 0, NULL);
+  for (int t = 2; t <= bench_max_threads; t *= 2)
+    bench_emit("push_pop", "mt_jobs", 0, t, run_mt(t, 1, 1), 0, NULL);
+
+  fprintf(bench_out, "\n  ]\n}\n");
+  if (bench_out != stdout)
+    fclose(bench_out);
+
+  rtq_cleanup(&q);
+  dl_params_cleanup();
+  return 0;
+}
@@ -0,0 +1,118 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rtq_shm.h"
+#include "stats.h"
+
+/*
+ * Test client for rtqueue --shm: submits jobs periodically through the
+ * shared-memory ring, busy-polls the completion ring and reports the
+ * round-trip latency (submission to completion received) of completed jobs.
+ *
+ * Start rtqueue first with the same name and -j at least the number of jobs
+ * (the client ends the stream after its last one):
+ *   rtqueue --shm /rtq -j 1000 ... &  rtq_client -n 1000 /rtq
+ */
+
+static long ts_diff_us(const struct timespec *a, const struct timespec *b) {
+  return (a->tv_sec - b->tv_sec) * 1000000l + (a->tv_nsec - b->tv_nsec) / 1000;
+}
+
+int main(int argc, char *argv[]) {
+  int num_jobs = 1000;
+  unsigned C_us = 100;
+  unsigned deadline_us = 10000;
+  unsigned period_us = 1000;
+
+  argc--;  argv++;
+  while (argc > 1) {
+    if (strcmp(*argv, "-n") == 0)
+      num_jobs = atoi(argv[1]);
+    else if (strcmp(*argv, "-c") == 0)
+      C_us = atoi(argv[1]);
+    else if (strcmp(*argv, "-d") == 0)
+      deadline_us = atoi(argv[1]);
+    else if (strcmp(*argv, "-p") == 0)
+      period_us = atoi(argv[1]);
+    else
+      break;
+    argc -= 2;  argv += 2;
+  }
+  if (argc != 1 || num_jobs <= 0) {
+    printf("Usage: rtq_client [-n jobs] [-c C_us] [-d deadline_us] [-p period_us] shm_name\n");
+    exit(EXIT_FAILURE);
+  }
+
+  rtq_shm_t *shm = NULL;
+  for (int i = 0; i < 100 && shm == NULL; i++) {
+    shm = rtq_shm_attach(*argv);
+    if (shm == NULL) {
+      struct timespec ts = { 0, 100000000 };
+      nanosleep(&ts, NULL);
+    }
+  }
+  if (shm == NULL) {
+    fprintf(stderr, "Could not attach to %s (is rtqueue --shm running?)\n", *argv);
+    exit(EXIT_FAILURE);
+  }
+
+  struct timespec *sent = calloc(num_jobs, sizeof(struct timespec));
+  if (sent == NULL) {
+    fprintf(stderr, "Out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+
+  RunningStats rtt, resp;
+  stats_init(&rtt);
+  stats_init(&resp);
+  long count[4] = { 0, 0, 0, 0 };
+
+  int submitted = 0, received = 0;
+  struct timespec ts_next;
+  clock_gettime(CLOCK_MONOTONIC, &ts_next);
+  while (received < num_jobs) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (submitted < num_jobs && ts_diff_us(&now, &ts_next) >= 0) {
+      rtq_shm_req_t req = { .id = submitted, .C_us = C_us, .deadline_us = deadline_us, .sent = now };
+      if (rtq_shm_submit(shm, &req)) {
+        sent[submitted++] = now;
+        if (submitted == num_jobs)
+          rtq_shm_end(shm);
+        ts_next.tv_nsec += period_us * 1000l;
+        while (ts_next.tv_nsec >= 1000000000l) {
+          ts_next.tv_nsec -= 1000000000l;
+          ts_next.tv_sec++;
+        }
+      }
+    }
+
+    rtq_shm_resp_t r;
+    while (rtq_shm_poll_complete(shm, &r)) {
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      if (r.id >= (uint64_t)submitted || r.status < 0 || r.status > RTQ_SHM_REJECTED)
+        continue;
+      count[r.status]++;
+      if (r.status == RTQ_SHM_DONE) {
+        stats_add(&rtt, ts_diff_us(&now, &sent[r.id]));
+        stats_add(&resp, r.elapsed_us);
+      }
+      received++;
+    }
+    rtq_shm_cpu_relax();
+  }
+
+  printf("jobs: %d done: %ld dismissed: %ld late: %ld rejected: %ld\n",
+         num_jobs, count[RTQ_SHM_DONE], count[RTQ_SHM_DISMISSED], count[RTQ_SHM_LATE], count[RTQ_SHM_REJECTED]);
+  stats_write_header(stdout);
+  stats_write_row(stdout, "RTT_us", &rtt);
+  stats_write_row(stdout, "RESP_us", &resp);
+
+  free(sent);
+  rtq_shm_detach(shm);
+  return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef RTQ_MEM_H
+#define RTQ_MEM_H
+
+/*
+ * Real-time memory mode for rtqueue (header-only).
+ *
+ * Locks the address space with mlockall(MCL_ONFAULT), so that pages stay
+ * resident once touched without populating the whole (mostly unused) BSS,
+ * then prefaults the arenas the hot path uses and the stack of each
+ * thread, so the measured run takes no page fault. Arenas of at least a
+ * huge page can be marked MADV_HUGEPAGE before prefaulting, to also cut
+ * the TLB misses of the large job arrays. Page faults of a thread are
+ * read with getrusage(RUSAGE_THREAD).
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#ifndef MCL_ONFAULT
+#define MCL_ONFAULT 4
+#endif
+
+#define RTQ_MEM_HUGE_PAGE (2ul << 20)
+#define RTQ_MEM_STACK_PREFAULT (256 * 1024)   // per thread
+
+typedef struct {
+  void *p;
+  size_t len;
+} rtq_mem_arena_t;
+
+/* Locks current and future pages as they get faulted in; 0 on success */
+static inline int rtq_mem_lock(void) {
+  return mlockall(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT);
+}
+
+/* Backs the huge-page-aligned part of [p, p + len) with transparent huge
+   pages, if any; call before the range is touched */
+static inline int rtq_mem_huge(void *p, size_t len) {
+  uintptr_t beg = ((uintptr_t)p + RTQ_MEM_HUGE_PAGE - 1) & ~(RTQ_MEM_HUGE_PAGE - 1);
+  uintptr_t end = ((uintptr_t)p + len) & ~(RTQ_MEM_HUGE_PAGE - 1);
+  if (end <= beg)
+    return 0;
+  return madvise((void *)beg, end - beg, MADV_HUGEPAGE);
+}
+
+/* Writes every page of [p, p + len), preserving its contents, and locks
+   it (a no-op after rtq_mem_lock() on kernels with MCL_ONFAULT) */
+static inline int rtq_mem_prefault(void *p, size_t len) {
+  if (len == 0)
+    return 0;
+  long page = sysconf(_SC_PAGESIZE);
+  volatile char *c = p;
+  for (size_t off = 0; off < len; off += page)
+    c[off] = c[off];
+  c[len - 1] = c[len - 1];
+  return mlock(p, len);
+}
+
+/* Touches RTQ_MEM_STACK_PREFAULT bytes of the calling thread stack */
+static __attribute__((noinline, unused)) void rtq_mem_prefault_stack(void) {
+  unsigned char buf[RTQ_MEM_STACK_PREFAULT];
+  memset(buf, 0, sizeof(buf));
+  __asm__ volatile("" : : "r"(buf) : "memory");
+}
+
+/* Minor and major page faults of the calling thread so far */
+static inline void rtq_mem_faults(long *p_minflt, long *p_majflt) {
+  struct rusage ru;
+  getrusage(RUSAGE_THREAD, &ru);
+  *p_minflt = ru.ru_minflt;
+  *p_majflt = ru.ru_majflt;
+}
+
+#endif
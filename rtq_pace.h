@@ -0,0 +1,115 @@
+#ifndef RTQ_PACE_H
+#define RTQ_PACE_H
+
+/*
+ * Release pacing for the rtqueue job generator (header-only).
+ *
+ * clock_nanosleep() alone wakes up tens of us after the requested time,
+ * and that latency ends up in every release at sub-100 us periods. In
+ * hybrid mode the generator sleeps till a margin before the release time,
+ * then spins on the (vDSO) monotonic clock till the release time. The
+ * margin follows the observed wake-up latency: it jumps above any larger
+ * latency at once and decays slowly towards smaller ones, so it sits near
+ * the high quantiles of the latency distribution. Hybrid mode also drops
+ * the timer slack of the calling thread (50 us by default for non-RT
+ * threads), which otherwise dominates the wake-up latency. Every release
+ * records its jitter (actual - requested release time, ns).
+ */
+
+#include <time.h>
+#include <errno.h>
+#include <sys/prctl.h>
+#include "dw_debug.h"
+#include "stats.h"
+
+enum {
+  RTQ_PACE_SLEEP,     // clock_nanosleep() only
+  RTQ_PACE_HYBRID,    // sleep till margin_ns before, then spin
+  RTQ_PACE_SPIN       // spin only
+};
+
+#define RTQ_PACE_MARGIN_MIN_NS 2000
+#define RTQ_PACE_MARGIN_MAX_NS 1000000
+#define RTQ_PACE_MARGIN_INIT_NS 50000
+#define RTQ_PACE_DECAY_SHIFT 6         // margin decays by 1/64 of the gap per sleep
+
+typedef struct {
+  int mode;
+  long margin_ns;
+  long sleeps;        // releases that slept (the others only spun)
+  long overruns;      // releases requested when already past
+  LogHist jitter_ns;  // actual - requested release time
+  LogHist wakeup_ns;  // clock_nanosleep() wake-up latency
+} rtq_pace_t;
+
+static inline const char *rtq_pace_mode_str(int mode) {
+  static const char *modes[] = { "sleep", "hybrid", "spin" };
+  return modes[mode];
+}
+
+static inline long rtq_pace_ns(const struct timespec *ts) {
+  return ts->tv_sec * 1000000000l + ts->tv_nsec;
+}
+
+static inline void rtq_pace_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ volatile("yield");
+#endif
+}
+
+/* Call from the pacing thread */
+static inline void rtq_pace_init(rtq_pace_t *p, int mode) {
+  p->mode = mode;
+  p->margin_ns = RTQ_PACE_MARGIN_INIT_NS;
+  p->sleeps = p->overruns = 0;
+  hist_init(&p->jitter_ns);
+  hist_init(&p->wakeup_ns);
+  if (mode == RTQ_PACE_HYBRID)
+    prctl(PR_SET_TIMERSLACK, 1, 0, 0, 0);
+}
+
+/* Sleeps and/or spins till the absolute CLOCK_MONOTONIC time *target */
+static inline void rtq_pace_until(rtq_pace_t *p, const struct timespec *target) {
+  struct timespec now;
+  long target_ns = rtq_pace_ns(target);
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if (rtq_pace_ns(&now) >= target_ns)
+    p->overruns++;
+
+  long wake_ns = p->mode == RTQ_PACE_SLEEP ? target_ns : target_ns - p->margin_ns;
+  if (p->mode != RTQ_PACE_SPIN && rtq_pace_ns(&now) < wake_ns) {
+    struct timespec wake = { wake_ns / 1000000000l, wake_ns % 1000000000l };
+    int rv;
+    while ((rv = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL)) == EINTR)
+      ;
+    check(rv == 0, "clock_nanosleep() failed!");
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long lat_ns = rtq_pace_ns(&now) - wake_ns;
+    hist_add(&p->wakeup_ns, lat_ns);
+    p->sleeps++;
+    if (p->mode == RTQ_PACE_HYBRID) {
+      if (lat_ns > p->margin_ns)
+        p->margin_ns = lat_ns + lat_ns / 4;
+      else
+        p->margin_ns -= (p->margin_ns - lat_ns) >> RTQ_PACE_DECAY_SHIFT;
+      if (p->margin_ns < RTQ_PACE_MARGIN_MIN_NS)
+        p->margin_ns = RTQ_PACE_MARGIN_MIN_NS;
+      if (p->margin_ns > RTQ_PACE_MARGIN_MAX_NS)
+        p->margin_ns = RTQ_PACE_MARGIN_MAX_NS;
+    }
+  } else if (p->mode == RTQ_PACE_HYBRID && p->margin_ns > RTQ_PACE_MARGIN_MIN_NS) {
+    // no sample without sleeping: decay anyway, or a single outlier
+    // larger than the period would leave the generator spinning for good
+    p->margin_ns -= p->margin_ns >> RTQ_PACE_DECAY_SHIFT;
+  }
+
+  while (rtq_pace_ns(&now) < target_ns) {
+    rtq_pace_relax();
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  }
+  hist_add(&p->jitter_ns, rtq_pace_ns(&now) - target_ns);
+}
+
+#endif
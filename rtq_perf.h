@@ -0,0 +1,147 @@
+#ifndef RTQ_PERF_H
+#define RTQ_PERF_H
+
+/*
+ * Per-thread performance counters for rtqueue (header-only).
+ *
+ * Each worker opens one perf_event_open() group counting its own thread:
+ * cycles, instructions and cache misses (hardware PMU) plus context
+ * switches and page faults (kernel software events). A group is read with a
+ * single read(), so all counters of a sample cover exactly the same
+ * interval. Events the machine cannot count (no PMU in most VMs, or a
+ * restrictive perf_event_paranoid) are left out of the group and read as
+ * 0; if perf_event_open() is not usable at all, context switches and page
+ * faults come from getrusage(RUSAGE_THREAD) instead.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+enum {
+  RTQ_PERF_CYCLES,
+  RTQ_PERF_INSTRUCTIONS,
+  RTQ_PERF_CACHE_MISSES,
+  RTQ_PERF_CTX_SWITCHES,
+  RTQ_PERF_PAGE_FAULTS,
+  RTQ_PERF_NUM
+};
+
+static inline const char *rtq_perf_name(int i) {
+  static const char *names[RTQ_PERF_NUM] = {
+    "cycles", "instructions", "cache-misses", "ctx-switches", "page-faults"
+  };
+  return names[i];
+}
+
+enum {
+  RTQ_PERF_MODE_HW,      // at least one hardware counter in the group
+  RTQ_PERF_MODE_SW,      // software events only
+  RTQ_PERF_MODE_RUSAGE   // perf_event_open() unusable: getrusage()
+};
+
+static inline const char *rtq_perf_mode_str(int mode) {
+  static const char *modes[] = { "hw", "sw", "rusage" };
+  return modes[mode];
+}
+
+typedef struct {
+  int leader;                // group leader fd, -1 in RUSAGE mode
+  int fd[RTQ_PERF_NUM];
+  int pos[RTQ_PERF_NUM];     // position in the group read, -1 if not counted
+  int nr;
+  int mode;
+} rtq_perf_t;
+
+/* Counter totals of one hot-path phase */
+typedef struct {
+  uint64_t n;
+  uint64_t v[RTQ_PERF_NUM];
+} rtq_perf_acc_t;
+
+static inline int rtq_perf_event_open(uint32_t type, uint64_t config, int group_fd) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = group_fd == -1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  int fd = syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+  if (fd < 0) {
+    // kernel-side counting may be forbidden by perf_event_paranoid
+    attr.exclude_kernel = 1;
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+  }
+  return fd;
+}
+
+/* Opens the counter group of the calling thread and starts it */
+static inline void rtq_perf_open(rtq_perf_t *p) {
+  static const struct { uint32_t type; uint64_t config; } ev[RTQ_PERF_NUM] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+  };
+  p->leader = -1;
+  p->nr = 0;
+  p->mode = RTQ_PERF_MODE_SW;
+  for (int i = 0; i < RTQ_PERF_NUM; i++) {
+    p->fd[i] = rtq_perf_event_open(ev[i].type, ev[i].config, p->leader);
+    p->pos[i] = -1;
+    if (p->fd[i] < 0)
+      continue;
+    if (p->leader == -1)
+      p->leader = p->fd[i];
+    if (ev[i].type == PERF_TYPE_HARDWARE)
+      p->mode = RTQ_PERF_MODE_HW;
+    p->pos[i] = p->nr++;
+  }
+  if (p->leader == -1) {
+    p->mode = RTQ_PERF_MODE_RUSAGE;
+    return;
+  }
+  ioctl(p->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(p->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+static inline void rtq_perf_close(rtq_perf_t *p) {
+  for (int i = 0; i < RTQ_PERF_NUM; i++)
+    if (p->fd[i] >= 0)
+      close(p->fd[i]);
+  p->leader = -1;
+}
+
+/* Current counter values (0 for the ones that are not counted) */
+static inline void rtq_perf_read(const rtq_perf_t *p, uint64_t v[RTQ_PERF_NUM]) {
+  memset(v, 0, RTQ_PERF_NUM * sizeof(uint64_t));
+  if (p->mode == RTQ_PERF_MODE_RUSAGE) {
+    struct rusage ru;
+    getrusage(RUSAGE_THREAD, &ru);
+    v[RTQ_PERF_CTX_SWITCHES] = ru.ru_nvcsw + ru.ru_nivcsw;
+    v[RTQ_PERF_PAGE_FAULTS] = ru.ru_minflt + ru.ru_majflt;
+    return;
+  }
+  uint64_t buf[1 + RTQ_PERF_NUM];
+  if (read(p->leader, buf, sizeof(buf)) < (ssize_t)sizeof(uint64_t))
+    return;
+  for (int i = 0; i < RTQ_PERF_NUM; i++)
+    if (p->pos[i] >= 0 && (uint64_t)p->pos[i] < buf[0])
+      v[i] = buf[1 + p->pos[i]];
+}
+
+/* Adds the counters between samples v0 and v1 to a phase */
+static inline void rtq_perf_acc(rtq_perf_acc_t *a, const uint64_t v0[RTQ_PERF_NUM], const uint64_t v1[RTQ_PERF_NUM]) {
+  a->n++;
+  for (int i = 0; i < RTQ_PERF_NUM; i++)
+    a->v[i] += v1[i] - v0[i];
+}
+
+#endif
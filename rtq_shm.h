@@ -0,0 +1,279 @@
+#ifndef RTQ_SHM_H
+#define RTQ_SHM_H
+
+/*
+ * Shared-memory job submission interface for rtqueue (header-only).
+ *
+ * A POSIX shared-memory object holds two bounded lock-free rings:
+ *  - submit:   clients -> rtqueue ingest thread (job descriptors)
+ *  - complete: rtqueue workers -> client (completion status)
+ *
+ * Each ring is a multi-producer/multi-consumer array queue with a sequence
+ * number per slot (D. Vyukov's bounded queue): enqueue/dequeue are a CAS on
+ * the position plus a store on the slot, no syscalls and no locks. Slots are
+ * written in place, so a descriptor is copied exactly once into the ring.
+ *
+ * Completions go to a single ring: with several clients, each one must
+ * recognize its own ids.
+ *
+ * A client marks the end of its submissions with rtq_shm_end() (with
+ * several clients, the last one to finish). The ingest side also watches
+ * the pid of the last attached client, so a client that dies without
+ * ending the stream does not leave rtqueue waiting forever, and backs off
+ * from spinning to short sleeps while the submit ring stays empty.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+#define RTQ_SHM_MAGIC 0x52545153u   // "RTQS"
+#define RTQ_SHM_VERSION 2
+#define RTQ_SHM_RING_SIZE 1024      // slots per ring, power of 2
+#define RTQ_SHM_CACHELINE 64
+#define RTQ_SHM_SPIN_POLLS 1000     // empty polls before sleeping between them
+#define RTQ_SHM_IDLE_SLEEP_NS 50000
+#define RTQ_SHM_LIVENESS_POLLS 1024 // empty polls between client liveness checks
+
+/* Job descriptor written by a client */
+typedef struct {
+  uint64_t id;               // client-chosen, echoed back in the completion
+  uint32_t C_us;             // computation time
+  uint32_t deadline_us;      // relative deadline, from sent
+  struct timespec sent;      // CLOCK_MONOTONIC at submission
+} rtq_shm_req_t;
+
+enum {
+  RTQ_SHM_DONE = 0,          // completed, elapsed_us is the response time
+  RTQ_SHM_DISMISSED = 1,     // started but dismissed (dismiss point, abort timer)
+  RTQ_SHM_LATE = 2,          // dropped from the queue after its deadline
+  RTQ_SHM_REJECTED = 3       // not admitted on push (RED drop / full queue)
+};
+
+/* Completion published back by rtqueue */
+typedef struct {
+  uint64_t id;
+  int32_t status;
+  int32_t pad;
+  int64_t elapsed_us;
+} rtq_shm_resp_t;
+
+/* One slot per cache line, so producers and consumers working on
+   neighboring slots do not share lines */
+typedef struct {
+  _Alignas(RTQ_SHM_CACHELINE) _Atomic uint64_t seq;
+  union {
+    rtq_shm_req_t req;
+    rtq_shm_resp_t resp;
+  };
+} rtq_shm_slot_t;
+
+typedef struct {
+  _Alignas(RTQ_SHM_CACHELINE) _Atomic uint64_t enq_pos;
+  _Alignas(RTQ_SHM_CACHELINE) _Atomic uint64_t deq_pos;
+  _Alignas(RTQ_SHM_CACHELINE) rtq_shm_slot_t slots[RTQ_SHM_RING_SIZE];
+} rtq_shm_ring_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  _Atomic uint32_t ready;    // set by rtqueue once both rings are initialized
+  _Atomic int32_t client_pid; // last attached client
+  _Atomic uint32_t ended;    // set by the client after its last submission
+  rtq_shm_ring_t submit;
+  rtq_shm_ring_t complete;
+} rtq_shm_t;
+
+/* Busy-wait hint for polling loops */
+static inline void rtq_shm_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+static inline void rtq_shm_ring_init(rtq_shm_ring_t *r) {
+  for (uint64_t i = 0; i < RTQ_SHM_RING_SIZE; i++)
+    atomic_store_explicit(&r->slots[i].seq, i, memory_order_relaxed);
+  atomic_store_explicit(&r->enq_pos, 0, memory_order_relaxed);
+  atomic_store_explicit(&r->deq_pos, 0, memory_order_relaxed);
+}
+
+/* Reserves the next free slot for writing, NULL if the ring is full */
+static inline rtq_shm_slot_t *rtq_shm_ring_claim(rtq_shm_ring_t *r, uint64_t *pos_out) {
+  uint64_t pos = atomic_load_explicit(&r->enq_pos, memory_order_relaxed);
+  for (;;) {
+    rtq_shm_slot_t *s = &r->slots[pos & (RTQ_SHM_RING_SIZE - 1)];
+    uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+    int64_t dif = (int64_t)seq - (int64_t)pos;
+    if (dif == 0) {
+      if (atomic_compare_exchange_weak_explicit(&r->enq_pos, &pos, pos + 1,
+                                                memory_order_relaxed, memory_order_relaxed)) {
+        *pos_out = pos;
+        return s;
+      }
+    } else if (dif < 0) {
+      return NULL;
+    } else {
+      pos = atomic_load_explicit(&r->enq_pos, memory_order_relaxed);
+    }
+  }
+}
+
+static inline void rtq_shm_ring_publish(rtq_shm_slot_t *s, uint64_t pos) {
+  atomic_store_explicit(&s->seq, pos + 1, memory_order_release);
+}
+
+/* Next filled slot for reading, NULL if the ring is empty */
+static inline rtq_shm_slot_t *rtq_shm_ring_peek(rtq_shm_ring_t *r, uint64_t *pos_out) {
+  uint64_t pos = atomic_load_explicit(&r->deq_pos, memory_order_relaxed);
+  for (;;) {
+    rtq_shm_slot_t *s = &r->slots[pos & (RTQ_SHM_RING_SIZE - 1)];
+    uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+    int64_t dif = (int64_t)seq - (int64_t)(pos + 1);
+    if (dif == 0) {
+      if (atomic_compare_exchange_weak_explicit(&r->deq_pos, &pos, pos + 1,
+                                                memory_order_relaxed, memory_order_relaxed)) {
+        *pos_out = pos;
+        return s;
+      }
+    } else if (dif < 0) {
+      return NULL;
+    } else {
+      pos = atomic_load_explicit(&r->deq_pos, memory_order_relaxed);
+    }
+  }
+}
+
+static inline void rtq_shm_ring_release(rtq_shm_slot_t *s, uint64_t pos) {
+  atomic_store_explicit(&s->seq, pos + RTQ_SHM_RING_SIZE, memory_order_release);
+}
+
+/* Creates (rtqueue side) or attaches to (client side) the named object */
+static inline rtq_shm_t *rtq_shm_map(const char *name, int create) {
+  int fd = shm_open(name, create ? O_CREAT | O_RDWR | O_TRUNC : O_RDWR, 0600);
+  if (fd < 0)
+    return NULL;
+  if (create && ftruncate(fd, sizeof(rtq_shm_t)) < 0) {
+    close(fd);
+    return NULL;
+  }
+  rtq_shm_t *shm = mmap(NULL, sizeof(rtq_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (shm == MAP_FAILED)
+    return NULL;
+
+  if (create) {
+    shm->magic = RTQ_SHM_MAGIC;
+    shm->version = RTQ_SHM_VERSION;
+    rtq_shm_ring_init(&shm->submit);
+    rtq_shm_ring_init(&shm->complete);
+    atomic_store_explicit(&shm->client_pid, 0, memory_order_relaxed);
+    atomic_store_explicit(&shm->ended, 0, memory_order_relaxed);
+    atomic_store_explicit(&shm->ready, 1, memory_order_release);
+  } else if (shm->magic != RTQ_SHM_MAGIC || shm->version != RTQ_SHM_VERSION
+             || !atomic_load_explicit(&shm->ready, memory_order_acquire)) {
+    munmap(shm, sizeof(rtq_shm_t));
+    return NULL;
+  } else {
+    atomic_store_explicit(&shm->client_pid, getpid(), memory_order_relaxed);
+  }
+  return shm;
+}
+
+static inline rtq_shm_t *rtq_shm_create(const char *name) {
+  return rtq_shm_map(name, 1);
+}
+
+static inline rtq_shm_t *rtq_shm_attach(const char *name) {
+  return rtq_shm_map(name, 0);
+}
+
+static inline void rtq_shm_detach(rtq_shm_t *shm) {
+  munmap(shm, sizeof(rtq_shm_t));
+}
+
+/* Client: submits a job, stamping sent if it is zero. Returns 0 if the ring is full */
+static inline int rtq_shm_submit(rtq_shm_t *shm, const rtq_shm_req_t *req) {
+  uint64_t pos;
+  rtq_shm_slot_t *s = rtq_shm_ring_claim(&shm->submit, &pos);
+  if (s == NULL)
+    return 0;
+  s->req = *req;
+  if (req->sent.tv_sec == 0 && req->sent.tv_nsec == 0)
+    clock_gettime(CLOCK_MONOTONIC, &s->req.sent);
+  rtq_shm_ring_publish(s, pos);
+  return 1;
+}
+
+/* rtqueue: takes the next submitted job. Returns 0 if none is pending */
+static inline int rtq_shm_poll_submit(rtq_shm_t *shm, rtq_shm_req_t *req) {
+  uint64_t pos;
+  rtq_shm_slot_t *s = rtq_shm_ring_peek(&shm->submit, &pos);
+  if (s == NULL)
+    return 0;
+  *req = s->req;
+  rtq_shm_ring_release(s, pos);
+  return 1;
+}
+
+/* rtqueue: publishes a completion. Returns 0 if the ring is full */
+static inline int rtq_shm_complete(rtq_shm_t *shm, uint64_t id, int status, long elapsed_us) {
+  uint64_t pos;
+  rtq_shm_slot_t *s = rtq_shm_ring_claim(&shm->complete, &pos);
+  if (s == NULL)
+    return 0;
+  s->resp.id = id;
+  s->resp.status = status;
+  s->resp.pad = 0;
+  s->resp.elapsed_us = elapsed_us;
+  rtq_shm_ring_publish(s, pos);
+  return 1;
+}
+
+/* Client: no more submissions will follow */
+static inline void rtq_shm_end(rtq_shm_t *shm) {
+  atomic_store_explicit(&shm->ended, 1, memory_order_release);
+}
+
+/* rtqueue: whether the client has ended the stream. Read it before polling
+   the submit ring: if set, an empty poll means all jobs were taken */
+static inline int rtq_shm_ended(rtq_shm_t *shm) {
+  return atomic_load_explicit(&shm->ended, memory_order_acquire);
+}
+
+/* rtqueue: 0 if the last attached client no longer exists */
+static inline int rtq_shm_client_alive(rtq_shm_t *shm) {
+  pid_t pid = atomic_load_explicit(&shm->client_pid, memory_order_relaxed);
+  return pid == 0 || kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+/* rtqueue: waits after the idle-th consecutive empty poll */
+static inline void rtq_shm_backoff(long idle) {
+  if (idle < RTQ_SHM_SPIN_POLLS) {
+    rtq_shm_cpu_relax();
+  } else {
+    struct timespec ts = { 0, RTQ_SHM_IDLE_SLEEP_NS };
+    nanosleep(&ts, NULL);
+  }
+}
+
+/* Client: takes the next completion. Returns 0 if none is pending */
+static inline int rtq_shm_poll_complete(rtq_shm_t *shm, rtq_shm_resp_t *resp) {
+  uint64_t pos;
+  rtq_shm_slot_t *s = rtq_shm_ring_peek(&shm->complete, &pos);
+  if (s == NULL)
+    return 0;
+  *resp = s->resp;
+  rtq_shm_ring_release(s, pos);
+  return 1;
+}
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef RTQ_TRACE_H
+#define RTQ_TRACE_H
+
+/*
+ * Low-overhead event tracer for rtqueue (header-only).
+ *
+ * Each thread registers its own ring of fixed-size binary events, so the
+ * fast path is a timestamp read plus three stores into memory only that
+ * thread writes: no locks, no atomics, no syscalls. When a ring wraps the
+ * oldest events are overwritten (and counted). Rings are read only after
+ * the threads are joined, by rtq_trace_dump(), which writes a Chrome trace
+ * JSON file (chrome://tracing, ui.perfetto.dev): pop and job executions are
+ * slices on each thread, and a flow arrow links every push to the start of
+ * the job, showing its queueing delay.
+ *
+ * Timestamps are raw TSC on x86 (invariant TSC assumed), the virtual counter
+ * on aarch64, CLOCK_MONOTONIC_RAW elsewhere; they are converted to ns at
+ * dump time against CLOCK_MONOTONIC_RAW samples taken at enable and dump.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef RTQ_TRACE_EVENTS
+#define RTQ_TRACE_EVENTS (1 << 18)  // events per thread, power of 2
+#endif
+#define RTQ_TRACE_MAX_THREADS 256
+
+enum {
+  RTQ_EV_PUSH,          // job queued, arg: queue size after the push
+  RTQ_EV_PUSH_FULL,     // push failed on a full queue
+  RTQ_EV_RED_DROP,      // push dropped by RED, arg: p_drop in ppm
+  RTQ_EV_POP_START,
+  RTQ_EV_POP_END,       // job: popped job (-1 if none)
+  RTQ_EV_LATE_DROP,     // job removed from the queue after its deadline
+  RTQ_EV_JOB_START,     // arg: C_us
+  RTQ_EV_JOB_FINISH,    // arg: response time (us)
+  RTQ_EV_DISMISS,       // job stopped at the dismiss point
+  RTQ_EV_CBS_PERIOD,    // new SCHED_DEADLINE period seen, arg: runtime left (ns)
+  RTQ_EV_ABORT,         // job stopped by its abort timer, arg: CPU time used (us)
+  RTQ_EV_NUM
+};
+
+typedef struct {
+  uint64_t ts;          // raw clock ticks
+  int64_t arg;
+  int32_t job;          // index in jobs[], -1 when not about a job
+  uint32_t type;
+} rtq_trace_ev_t;
+
+typedef struct {
+  uint64_t head;        // number of events ever written
+  char name[32];
+  int tid;
+  rtq_trace_ev_t ev[RTQ_TRACE_EVENTS];
+} rtq_trace_buf_t;
+
+static int rtq_trace_on = 0;
+static rtq_trace_buf_t *rtq_trace_bufs[RTQ_TRACE_MAX_THREADS];
+static int rtq_trace_nbufs = 0;
+static uint64_t rtq_trace_tick0, rtq_trace_ns0;
+static __thread rtq_trace_buf_t *rtq_trace_self = NULL;
+
+static inline uint64_t rtq_trace_clock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t v;
+  __asm__ volatile("mrs %0, cntvct_el0" : "=r"(v));
+  return v;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static inline uint64_t rtq_trace_raw_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Enables tracing; call before the traced threads start */
+static inline void rtq_trace_enable(void) {
+  rtq_trace_ns0 = rtq_trace_raw_ns();
+  rtq_trace_tick0 = rtq_trace_clock();
+  rtq_trace_on = 1;
+}
+
+/* Registers the calling thread; events of unregistered threads are ignored */
+static inline int rtq_trace_thread(const char *name, int tid) {
+  if (!rtq_trace_on)
+    return 1;
+  int i = __atomic_fetch_add(&rtq_trace_nbufs, 1, __ATOMIC_RELAXED);
+  if (i >= RTQ_TRACE_MAX_THREADS)
+    return 0;
+  rtq_trace_buf_t *b = malloc(sizeof(rtq_trace_buf_t));
+  if (b == NULL)
+    return 0;
+  b->head = 0;
+  snprintf(b->name, sizeof(b->name), "%s", name);
+  b->tid = tid;
+  // touch the ring now, so page faults do not land on the traced path
+  for (size_t k = 0; k < RTQ_TRACE_EVENTS; k++)
+    b->ev[k].type = RTQ_EV_NUM;
+  rtq_trace_bufs[i] = b;
+  rtq_trace_self = b;
+  return 1;
+}
+
+static inline void rtq_trace_emit(uint32_t type, int32_t job, int64_t arg) {
+  rtq_trace_buf_t *b = rtq_trace_self;
+  if (b == NULL)
+    return;
+  rtq_trace_ev_t *e = &b->ev[b->head & (RTQ_TRACE_EVENTS - 1)];
+  e->ts = rtq_trace_clock();
+  e->arg = arg;
+  e->job = job;
+  e->type = type;
+  b->head++;
+}
+
+#define RTQ_TRACE(type, job, arg)                \
+  do {                                           \
+    if (rtq_trace_on)                            \
+      rtq_trace_emit((type), (job), (arg));      \
+  } while (0)
+
+static inline void rtq_trace_json_ev(FILE *f, int *first, const char *name, const char *ph,
+                                     double ts_us, int tid, int32_t job, int64_t arg) {
+  fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+          *first ? "" : ",", name, ph, ts_us, tid);
+  if (ph[0] == 'i')
+    fprintf(f, ",\"s\":\"t\"");
+  fprintf(f, ",\"args\":{\"job\":%d,\"arg\":%ld}}", job, (long)arg);
+  *first = 0;
+}
+
+/*
+ * Writes all rings to path as Chrome trace JSON and frees them; call after
+ * the traced threads are joined. Returns the number of events written.
+ */
+static inline long rtq_trace_dump(const char *path) {
+  uint64_t ns1 = rtq_trace_raw_ns();
+  uint64_t tick1 = rtq_trace_clock();
+  double ns_per_tick = tick1 > rtq_trace_tick0
+    ? (double)(ns1 - rtq_trace_ns0) / (tick1 - rtq_trace_tick0) : 1.0;
+
+  FILE *f = fopen(path, "w");
+  if (f == NULL) {
+    perror("fopen() of trace file failed");
+    return -1;
+  }
+
+  static const char *names[RTQ_EV_NUM] = {
+    "push", "push_full", "red_drop", "pop", "pop", "late_drop",
+    "job", "job", "dismiss", "cbs_period", "abort"
+  };
+  long written = 0;
+  uint64_t lost = 0;
+  int first = 1;
+  int n = rtq_trace_nbufs < RTQ_TRACE_MAX_THREADS ? rtq_trace_nbufs : RTQ_TRACE_MAX_THREADS;
+
+  fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  for (int i = 0; i < n; i++) {
+    rtq_trace_buf_t *b = rtq_trace_bufs[i];
+    if (b == NULL)
+      continue;
+    fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",", b->tid, b->name);
+    first = 0;
+
+    uint64_t beg = b->head > RTQ_TRACE_EVENTS ? b->head - RTQ_TRACE_EVENTS : 0;
+    lost += beg;
+    // a wrapped ring may start inside a slice: skip ends without a begin
+    int in_pop = 0, in_job = 0;
+    for (uint64_t k = beg; k < b->head; k++) {
+      rtq_trace_ev_t *e = &b->ev[k & (RTQ_TRACE_EVENTS - 1)];
+      double ts_us = (int64_t)(e->ts - rtq_trace_tick0) * ns_per_tick / 1000.0;
+      const char *name = names[e->type];
+      switch (e->type) {
+      case RTQ_EV_POP_START:
+        in_pop = 1;
+        rtq_trace_json_ev(f, &first, name, "B", ts_us, b->tid, e->job, e->arg);
+        break;
+      case RTQ_EV_POP_END:
+        if (!in_pop)
+          continue;
+        in_pop = 0;
+        rtq_trace_json_ev(f, &first, name, "E", ts_us, b->tid, e->job, e->arg);
+        break;
+      case RTQ_EV_JOB_START:
+        in_job = 1;
+        // flow from the push of this job
+        fprintf(f, ",\n{\"name\":\"queued\",\"cat\":\"job\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%d,\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                e->job, ts_us, b->tid);
+        rtq_trace_json_ev(f, &first, name, "B", ts_us, b->tid, e->job, e->arg);
+        break;
+      case RTQ_EV_JOB_FINISH:
+      case RTQ_EV_DISMISS:
+      case RTQ_EV_ABORT:
+        if (!in_job)
+          continue;
+        in_job = 0;
+        if (e->type != RTQ_EV_JOB_FINISH)
+          rtq_trace_json_ev(f, &first, name, "i", ts_us, b->tid, e->job, e->arg);
+        rtq_trace_json_ev(f, &first, "job", "E", ts_us, b->tid, e->job, e->arg);
+        break;
+      case RTQ_EV_PUSH:
+        rtq_trace_json_ev(f, &first, name, "i", ts_us, b->tid, e->job, e->arg);
+        if (e->job >= 0)
+          fprintf(f, ",\n{\"name\":\"queued\",\"cat\":\"job\",\"ph\":\"s\",\"id\":%d,\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                  e->job, ts_us, b->tid);
+        break;
+      default:
+        if (e->type >= RTQ_EV_NUM)
+          continue;
+        rtq_trace_json_ev(f, &first, name, "i", ts_us, b->tid, e->job, e->arg);
+        break;
+      }
+      written++;
+    }
+    free(b);
+    rtq_trace_bufs[i] = NULL;
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+
+  if (lost > 0)
+    fprintf(stderr, "trace: %lu events overwritten (RTQ_TRACE_EVENTS=%d per thread)\n",
+            (unsigned long)lost, RTQ_TRACE_EVENTS);
+  return written;
+}
+
+#endif
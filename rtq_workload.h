@@ -0,0 +1,164 @@
+#ifndef RTQ_WORKLOAD_H
+#define RTQ_WORKLOAD_H
+
+/*
+ * Multi-stream workloads for the rtqueue job generator (header-only).
+ *
+ * Each stream replays the computation times of one trace file, one job
+ * every period_us, each with the same relative deadline. Trace lines are
+ * "index,seconds" (traces/MPC_times) or a single column in seconds; empty,
+ * comment and non-numeric lines are skipped. Streams are merged by release
+ * time with a binary min-heap of their next jobs, so only one pending job
+ * per stream is in memory, whatever the trace lengths. Ties go to the
+ * stream given first.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "stats.h"
+
+#define RTQ_MAX_STREAMS 16
+
+typedef struct {
+  const char *path;
+  long period_us;
+  long deadline_us;
+  FILE *f;
+  long next_rel_us;   // release time of the pending job, from the run start
+  double next_C_us;   // computation time of the pending job
+  long num_jobs;      // valid lines in the trace
+  // results
+  long sent;
+  long rejected;
+  long done;
+  long missed;        // completed after the stream deadline
+  LogHist elapsed;    // response time of completed jobs (us)
+} rtq_stream_t;
+
+typedef struct {
+  int n;
+  rtq_stream_t s[RTQ_MAX_STREAMS];
+  int heap[RTQ_MAX_STREAMS];   // indexes into s[], earliest release on top
+  int heap_n;
+} rtq_workload_t;
+
+/* Reads the next computation time (us) from f, 0 at EOF */
+static inline int rtq_workload_read(FILE *f, double *p_C_us) {
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    long index;
+    double sec;
+    if (sscanf(line, "%ld,%lf", &index, &sec) != 2 && sscanf(line, "%lf", &sec) != 1)
+      continue;
+    if (sec <= 0)
+      continue;
+    *p_C_us = sec * 1e6;
+    return 1;
+  }
+  return 0;
+}
+
+static inline int rtq_workload_before(const rtq_workload_t *w, int a, int b) {
+  const rtq_stream_t *sa = &w->s[a], *sb = &w->s[b];
+  return sa->next_rel_us < sb->next_rel_us || (sa->next_rel_us == sb->next_rel_us && a < b);
+}
+
+static inline void rtq_workload_sift_down(rtq_workload_t *w, int i) {
+  for (;;) {
+    int min = i, l = 2 * i + 1, r = l + 1;
+    if (l < w->heap_n && rtq_workload_before(w, w->heap[l], w->heap[min]))
+      min = l;
+    if (r < w->heap_n && rtq_workload_before(w, w->heap[r], w->heap[min]))
+      min = r;
+    if (min == i)
+      return;
+    int tmp = w->heap[i];
+    w->heap[i] = w->heap[min];
+    w->heap[min] = tmp;
+    i = min;
+  }
+}
+
+/* Adds a stream; returns 0 if there are too many */
+static inline int rtq_workload_add(rtq_workload_t *w, const char *path, long period_us, long deadline_us) {
+  if (w->n == RTQ_MAX_STREAMS)
+    return 0;
+  rtq_stream_t *s = &w->s[w->n++];
+  memset(s, 0, sizeof(*s));
+  s->path = path;
+  s->period_us = period_us;
+  s->deadline_us = deadline_us;
+  hist_init(&s->elapsed);
+  return 1;
+}
+
+/* Opens the traces, counts their jobs and loads the first job of each
+   stream; returns the total number of jobs, -1 if a trace cannot be read */
+static inline long rtq_workload_open(rtq_workload_t *w) {
+  long tot = 0;
+  w->heap_n = 0;
+  for (int i = 0; i < w->n; i++) {
+    rtq_stream_t *s = &w->s[i];
+    s->f = fopen(s->path, "r");
+    if (s->f == NULL) {
+      perror("fopen() of workload trace failed");
+      return -1;
+    }
+    double C_us;
+    while (rtq_workload_read(s->f, &C_us))
+      s->num_jobs++;
+    rewind(s->f);
+    tot += s->num_jobs;
+    s->next_rel_us = 0;
+    if (rtq_workload_read(s->f, &s->next_C_us))
+      w->heap[w->heap_n++] = i;
+  }
+  for (int i = w->heap_n / 2 - 1; i >= 0; i--)
+    rtq_workload_sift_down(w, i);
+  return tot;
+}
+
+/* Release time of the next job (us from the run start), -1 if none left */
+static inline long rtq_workload_peek(const rtq_workload_t *w) {
+  return w->heap_n > 0 ? w->s[w->heap[0]].next_rel_us : -1;
+}
+
+/* Takes the next job in release order: returns its stream, -1 if none left */
+static inline int rtq_workload_next(rtq_workload_t *w, long *p_rel_us, double *p_C_us) {
+  if (w->heap_n == 0)
+    return -1;
+  int i = w->heap[0];
+  rtq_stream_t *s = &w->s[i];
+  *p_rel_us = s->next_rel_us;
+  *p_C_us = s->next_C_us;
+  s->sent++;
+  if (rtq_workload_read(s->f, &s->next_C_us))
+    s->next_rel_us += s->period_us;
+  else
+    w->heap[0] = w->heap[--w->heap_n];
+  rtq_workload_sift_down(w, 0);
+  return i;
+}
+
+/* Records the outcome of a job of stream i (elapsed_us as in job_t) */
+static inline void rtq_workload_account(rtq_workload_t *w, int i, long elapsed_us) {
+  rtq_stream_t *s = &w->s[i];
+  if (elapsed_us < 0) {
+    s->rejected++;
+  } else if (elapsed_us > 0) {
+    s->done++;
+    if (elapsed_us > s->deadline_us)
+      s->missed++;
+    hist_add(&s->elapsed, elapsed_us);
+  }
+}
+
+static inline void rtq_workload_close(rtq_workload_t *w) {
+  for (int i = 0; i < w->n; i++)
+    if (w->s[i].f != NULL) {
+      fclose(w->s[i].f);
+      w->s[i].f = NULL;
+    }
+}
+
+#endif
@@ -6,35 +6,62 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <errno.h>
+#include <signal.h>
 
 #include "distrib.h"
 #include "ts.h"
 #include "estim.h"
 #include "dw_debug.h"
 #include "dl_util.h"
-
-/* Data structure representing a job submitted to the JAMS system */
+#include "stats.h"
+#include "rtq_shm.h"
+#include "rtq_trace.h"
+#include "rtq_perf.h"
+#include "rtq_pace.h"
+#include "rtq_workload.h"
+#include "rtq_mem.h"
+
+#define RTQ_CACHELINE 64
+
+/* Data structure representing a job submitted to the JAMS system. Filled
+   by the producer, then read and completed (elapsed_us) by the worker that
+   pops it, while the producer fills the next ones: one cache line per job,
+   so adjacent jobs never share a line between the two */
 typedef struct {
   unsigned int C_us;
+  int stream;      // --workload stream, -1 otherwise
   struct timespec deadline_ts;
   struct timespec sent;
   long elapsed_us;
-} job_t;
+  uint64_t shm_id; // client id of jobs submitted through --shm
+  long id;         // request number
+} __attribute__((aligned(RTQ_CACHELINE))) job_t;
+
+_Static_assert(sizeof(job_t) == RTQ_CACHELINE, "job_t must fit one cache line");
 
 #define MAX_SIZE 128
 
-/* Data structure representing a globally shared JAMS queue */
+/* Data structure representing a globally shared JAMS queue. Every critical
+   section takes the mutex and updates head or tail and size, so they share
+   its line: splitting producer (head) and consumer (tail) indexes would
+   only add a line transfer per operation under a single lock. The condvars
+   are also written by threads waking up outside of the critical section,
+   and the slots by the pushing thread, so each gets its own lines. */
 typedef struct {
-  job_t *elems[MAX_SIZE];
+  pthread_mutex_t mtx;   // mutex for concurrent access to the shared JAMS queue
   int head; // head of the queue
   int tail; // tail of the queue
   int size; // size of the queue
-  pthread_mutex_t mtx;   // mutex for concurrent access to the shared JAMS queue
-  pthread_cond_t empty;  // condvar where a reader blocks on pull(), and gets notified by another thread on push()
+  // condvar where a reader blocks on pull(), and gets notified by another thread on push()
+  pthread_cond_t empty __attribute__((aligned(RTQ_CACHELINE)));
 
   /* Note: the blocking logic on push() was NOT needed for the JAMS paper runs */
-  pthread_cond_t full;   // condvar where a writer blocks on push(), and gets notified by another thread on pull()
-} rtqueue_t;
+  // condvar where a writer blocks on push(), and gets notified by another thread on pull()
+  pthread_cond_t full __attribute__((aligned(RTQ_CACHELINE)));
+  job_t *elems[MAX_SIZE] __attribute__((aligned(RTQ_CACHELINE)));
+} __attribute__((aligned(RTQ_CACHELINE))) rtqueue_t;
 
 // used when exiting the program
 int exiting = 0;
@@ -50,8 +77,35 @@ double u_tot = NAN;
 int affinity_cpu = -1;
 int fine_tune = 0;
 int measure_overheads = 0;
+int perf_counters = 0;
+int dump_requests = 1;
 unsigned long dismiss_point_us = 0;
 
+/* --abort: jobs are stopped asynchronously by a per-worker POSIX timer,
+   armed at job start on the deadline or on the dismiss point, whose
+   signal sets job_abort; the job body only checks that flag */
+#define ABORT_NONE     0
+#define ABORT_DEADLINE 1
+#define ABORT_DISMISS  2
+int abort_mode = ABORT_NONE;
+#define ABORT_SIGNAL (SIGRTMIN + 1)
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+__thread volatile sig_atomic_t job_abort = 0;
+char *stats_path = NULL;
+char *shm_name = NULL;
+char *trace_path = NULL;
+long ref_sent_us = 0;   // sent time of the first job
+int pace_mode = RTQ_PACE_SLEEP;
+rtq_pace_t pace;      // release pacing of the job generator
+rtq_shm_t *shm = NULL;
+rtq_workload_t workload;   // --workload streams
+int mem_lock = 0;          // --mlock: lock and prefault the hot-path memory
+int mem_huge = 0;          // --hugepages: back the large arenas with THP
+long gen_minflt = 0;       // page faults of the generator (or ingest) thread during the run
+long gen_majflt = 0;
+
 unsigned long dl_runtime_us = 0;
 unsigned long dl_period_us = 0;
 
@@ -59,7 +113,15 @@ unsigned long dl_period_us = 0;
 job_t jobs[MAX_NUM_REQS];
 
 // A dummy job used to cause workers to exit
-job_t dummy = { 0, { 0, 0 }, { 0, 0 }, 0 };
+job_t dummy = { .stream = -1 };
+
+// Returned by rtq_pop() to a worker that has to park (--elastic)
+job_t park_job = { .stream = -1 };
+
+/* Request number of a job for the tracer, -1 for the dummy/park jobs */
+static inline int job_idx(job_t *p_job) {
+  return p_job == &dummy || p_job == &park_job || p_job == NULL ? -1 : (int)p_job->id;
+}
 
 /* Data structure representing the information passed to each JAMS
    worker thread when created */
@@ -70,22 +132,94 @@ typedef struct {
 
 rtqueue_t q;
 
-int num_reqs = 10;
+long num_reqs = 10;
 int num_child = 1;
 
 #define MAX_NUM_CHILD 128
 thread_info_t child[MAX_NUM_CHILD];
 
-unsigned long push_elapsed_ns[MAX_NUM_REQS];
-unsigned long pop_elapsed_ns[MAX_NUM_CHILD][MAX_NUM_REQS];
-int pop_elapsed_num[MAX_NUM_CHILD];
+/* --elastic: workers beyond elastic_min park after park_idle_us without
+   jobs, dropping their SCHED_DEADLINE reservation, and rtq_push() unparks
+   one when the queue occupancy (or the RED average, while RED is active)
+   exceeds unpark_th jobs per active worker. State protected by q.mtx. */
+int elastic_min = 0;                // 0: fixed pool, no parking
+unsigned long park_idle_us = 50000;
+double unpark_th = 2.0;
+
+typedef struct {
+  pthread_cond_t cond;              // the parked worker waits here for wake
+  int wake;
+  struct timespec wake_ts;          // when rtq_push() decided to unpark it
+} __attribute__((aligned(RTQ_CACHELINE))) park_t;
+
+park_t park[MAX_NUM_CHILD];
+int parked_ids[MAX_NUM_CHILD];      // stack of the parked workers
+int num_parked = 0;
+int num_active = 0;                 // workers not parked
+
+// -o samples, num_reqs each, allocated only with -o
+unsigned long *push_elapsed_ns = NULL;
+unsigned long *pop_elapsed_ns[MAX_NUM_CHILD];
+
+/* --perf: counters around the pop critical section, the condvar waits
+   inside it (not counted in pop) and the job execution; -o: number of
+   pop_elapsed_ns samples. Updated on every pop, so one line per worker. */
+typedef struct {
+  rtq_perf_acc_t pop;
+  rtq_perf_acc_t wait;
+  rtq_perf_acc_t job;
+  int mode;
+  long pop_elapsed_num;
+} __attribute__((aligned(RTQ_CACHELINE))) worker_perf_t;
+
+worker_perf_t wperf[MAX_NUM_CHILD];
+
+__thread rtq_perf_t *my_perf = NULL;           // --perf counters of a worker
+__thread uint64_t my_wait_beg[RTQ_PERF_NUM];
+__thread uint64_t my_wait_v[RTQ_PERF_NUM];     // waits of the current pop
+
+/* Per-worker outcome counters and histograms (us), merged at exit */
+typedef struct {
+  LogHist elapsed;   // response time of completed jobs
+  LogHist queue;     // queueing delay, from sent to the start of execution
+  LogHist slack;     // deadline - completion time (negative: deadline miss)
+  long done;
+  long dismissed;
+  long late;         // dropped from the queue after their deadline
+  long missed;       // completed after their deadline
+  LogHist spinup;    // --elastic: from the unpark decision to popping again
+  long parks;
+  long active_us;    // time spent unparked, holding the CBS reservation
+  long cpu_us;       // thread CPU time
+  long aborted;      // --abort: stopped by the abort timer
+  long aborted_us;   // CPU time burnt by the aborted jobs
+  LogHist abort_lat; // from the abort point to the job actually stopping
+  long minflt;       // page faults of the thread after the start barrier
+  long majflt;
+} __attribute__((aligned(RTQ_CACHELINE))) worker_stats_t;
+
+worker_stats_t wstats[MAX_NUM_CHILD];
+__thread worker_stats_t *my_wstats = NULL;
+
+/* Counters have a single writer each, and the controller reads them while
+   the run goes on: relaxed atomic accesses, no RMW */
+#define STAT_INC(x) __atomic_store_n(&(x), (x) + 1, __ATOMIC_RELAXED)
+#define STAT_GET(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+
+long push_accepted __attribute__((aligned(RTQ_CACHELINE))) = 0;   // written by the generator (or ingest) thread only
+long push_rejected = 0;
 
 /* Initialization function, to be called before any other operation on
    a rtqueue_t instance */
 void rtq_init(rtqueue_t *pq) {
   pq->head = pq->tail = pq->size = 0;
   pthread_mutex_init(&pq->mtx, NULL);
-  pthread_cond_init(&pq->empty, NULL);
+  // monotonic, for the idle timeout of --elastic workers
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&pq->empty, &attr);
+  pthread_condattr_destroy(&attr);
   pthread_cond_init(&pq->full, NULL);
 }
 
@@ -97,6 +231,85 @@ void rtq_cleanup(rtqueue_t *pq) {
   pthread_cond_destroy(&pq->full);
 }
 
+/* --pool: jobs come from a pool of pool_size slots instead of jobs[], so
+   runs have no length limit and constant memory. The generator (or ingest)
+   thread allocates from its private free list, without locks. Whoever
+   settles a job (the worker, or the generator for a rejected push) hands
+   it to the collector thread over its own single-producer single-consumer
+   ring; the collector streams the result out and gives the slot back to
+   the generator over another ring. */
+typedef struct {
+  unsigned long head __attribute__((aligned(64)));  // written by the producer only
+  unsigned long tail __attribute__((aligned(64)));  // written by the consumer only
+  unsigned long mask;
+  job_t **slots;
+} job_ring_t;
+
+int pool_size = 0;                    // 0: jobs[] indexed by request number
+job_t *pool_jobs = NULL;
+job_t **pool_cache = NULL;            // free list of the generator
+int pool_cached = 0;
+long pool_stalls = 0;                 // allocations that waited for a free slot
+job_ring_t done_rings[MAX_NUM_CHILD + 1];  // settled jobs, one per worker + generator
+job_ring_t free_ring;                 // recycled slots, collector -> generator
+__thread job_ring_t *my_done_ring = NULL;
+
+void job_ring_init(job_ring_t *r, unsigned long min_size) {
+  unsigned long size = 1;
+  while (size < min_size)
+    size <<= 1;
+  r->head = r->tail = 0;
+  r->mask = size - 1;
+  r->slots = malloc(size * sizeof(job_t *));
+  check(r->slots != NULL, "malloc() failed!");
+}
+
+int job_ring_put(job_ring_t *r, job_t *p_job) {
+  unsigned long head = r->head;
+  if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) > r->mask)
+    return 0;
+  r->slots[head & r->mask] = p_job;
+  __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+job_t *job_ring_get(job_ring_t *r) {
+  unsigned long tail = r->tail;
+  if (tail == __atomic_load_n(&r->head, __ATOMIC_ACQUIRE))
+    return NULL;
+  job_t *p_job = r->slots[tail & r->mask];
+  __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+  return p_job;
+}
+
+/* Publish the outcome of a job to its --shm client and, with --pool, hand
+   it over to the collector: the caller must not touch it afterwards */
+void rtq_notify(job_t *p_job, int status) {
+  if (p_job == &dummy || p_job == &park_job)
+    return;
+  // slow path only when the client is not draining completions
+  for (long i = 1; shm != NULL && !rtq_shm_complete(shm, p_job->shm_id, status, p_job->elapsed_us); i++) {
+    if (i % RTQ_SHM_LIVENESS_POLLS == 0 && !rtq_shm_client_alive(shm))
+      break;   // nobody left to drain it
+    sched_yield();
+  }
+  // rings hold the whole pool, this never fails
+  if (pool_size > 0)
+    check(job_ring_put(my_done_ring, p_job));
+}
+
+/* Late drops found under q.mtx: rtq_notify() may wait for a --shm client
+   to drain its completion ring, so they are notified by rtq_pop() once the
+   lock is released. At most one queue worth per rtq_pop_dl_nosync(). */
+__thread job_t *late_pending[MAX_SIZE];
+__thread int late_npending = 0;
+
+void rtq_notify_late_flush(void) {
+  for (int i = 0; i < late_npending; i++)
+    rtq_notify(late_pending[i], RTQ_SHM_LATE);
+  late_npending = 0;
+}
+
 // Variaveis global do RED
 double red_min_th = 20;   // exemplo
 double red_max_th = 80;   // exemplo
@@ -105,39 +318,88 @@ double red_max_p  = 0.1;  // probabilidade máxima 10%
 double red_avg = 0.0;     // average queue length
 double red_w_q = 0.002;   // weight do moving average (padrão RED)
 
+/* Admission knobs as seen by rtq_push() and rtq_pop_dl_nosync(). They start
+   from the command-line values and are republished by the --controller
+   thread through a seqlock: readers take a consistent snapshot with no
+   lock and no atomic RMW, retrying only if a publish raced with them. */
+typedef struct {
+  int push_drop_size;
+  double red_min_th;
+  double red_max_th;
+  double red_max_p;
+  double comp_time_perc_us;
+  double prob_dismiss_wcet_us;
+} knobs_t;
+
+knobs_t knobs __attribute__((aligned(RTQ_CACHELINE)));
+unsigned knobs_seq __attribute__((aligned(RTQ_CACHELINE))) = 0;   // odd while a publish is in progress
+
+/* Single writer (main before the threads start, then the controller) */
+void knobs_publish(const knobs_t *k) {
+  __atomic_store_n(&knobs_seq, knobs_seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(&knobs, k, sizeof(knobs));
+  __atomic_store_n(&knobs_seq, knobs_seq + 1, __ATOMIC_RELEASE);
+}
+
+void knobs_read(knobs_t *k) {
+  unsigned s1, s2;
+  do {
+    s1 = __atomic_load_n(&knobs_seq, __ATOMIC_ACQUIRE);
+    memcpy(k, &knobs, sizeof(*k));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    s2 = __atomic_load_n(&knobs_seq, __ATOMIC_RELAXED);
+  } while ((s1 & 1) || s1 != s2);
+}
+
+
+/* Unpark the most recently parked worker; call with q.mtx held */
+void pool_unpark() {
+  int id = parked_ids[--num_parked];
+  park[id].wake = 1;
+  clock_gettime(CLOCK_MONOTONIC, &park[id].wake_ts);
+  num_active++;
+  pthread_cond_signal(&park[id].cond);
+}
 
 /* Push the specified job into the shared JAMS queue */
 int rtq_push(rtqueue_t *pq, job_t *p_elem) {
     dw_log("pushing job %ld (%p)\n", p_elem - jobs, (void*)p_elem);
     int rv = 0;
+    knobs_t k;
+    knobs_read(&k);
+    double occupancy = 0.0;
     pthread_mutex_lock(&pq->mtx);
-    if (pq->size == MAX_SIZE)
+    if (pq->size == MAX_SIZE) {
+        RTQ_TRACE(RTQ_EV_PUSH_FULL, job_idx(p_elem), pq->size);
         goto unlock;
+    }
 
     /* --- RED CLASSIC DROP POLICY -------------------------------- */
 
       /* só ativa RED quando a fila entra na zona "congestionada"
        (equivalente ao push_drop_size como base de ativação) */
-    if (pq->size > push_drop_size) {
+    if (pq->size > k.push_drop_size) {
 
         /* Atualiza a média móvel exponencial */
         red_avg = (1.0 - red_w_q) * red_avg + red_w_q * pq->size;
+        occupancy = red_avg;
 
         double p_drop = 0.0;
 
-        if (red_avg < red_min_th) {
+        if (red_avg < k.red_min_th) {
             /* Não descarta */
             p_drop = 0.0;
 
-        } else if (red_avg >= red_max_th) {
+        } else if (red_avg >= k.red_max_th) {
             /* Descarte total */
             p_drop = 1.0;
 
         } else {
             /* Descarta com probabilidade crescente (linear) */
-            p_drop = red_max_p *
-                    (red_avg - red_min_th) /
-                    (red_max_th - red_min_th);
+            p_drop = k.red_max_p *
+                    (red_avg - k.red_min_th) /
+                    (k.red_max_th - k.red_min_th);
         }
 
         /* Decide descartar conforme p_drop */
@@ -147,6 +409,7 @@ int rtq_push(rtqueue_t *pq, job_t *p_elem) {
             if (r < p_drop) {
                 dw_log("[RED] drop job p=%f avg=%f size=%d\n",
                        p_drop, red_avg, pq->size);
+                RTQ_TRACE(RTQ_EV_RED_DROP, job_idx(p_elem), (long)(p_drop * 1e6));
                 goto unlock;   /* descarta o push */
             }
         }
@@ -157,9 +420,14 @@ int rtq_push(rtqueue_t *pq, job_t *p_elem) {
     pq->elems[pq->head] = p_elem;
     pq->head = (pq->head + 1) % MAX_SIZE;
     pq->size++;
+    RTQ_TRACE(RTQ_EV_PUSH, job_idx(p_elem), pq->size);
     pthread_cond_broadcast(&pq->empty);
     rv = 1;
 
+    if (num_parked > 0 && p_elem != &dummy
+        && fmax(occupancy, pq->size) > unpark_th * num_active)
+        pool_unpark();
+
 unlock:
     pthread_mutex_unlock(&pq->mtx);
     
@@ -187,7 +455,7 @@ job_t *rtq_popn_nosync(rtqueue_t *pq, int n) {
     return NULL;
   job_t *p_elem = pq->elems[(pq->tail + n) % MAX_SIZE];
   for (int i = pq->tail + n; i > pq->tail; i--)
-    pq->elems[(i-1) % MAX_SIZE] = pq->elems[i % MAX_SIZE];
+    pq->elems[i % MAX_SIZE] = pq->elems[(i-1) % MAX_SIZE];
   pq->tail = (pq->tail + 1) % MAX_SIZE;
   pq->size--;
 
@@ -198,6 +466,103 @@ long lmax(long a, long b) {
   return a > b ? a : b;
 }
 
+/* --virtual: simulated clock and user-space model of the SCHED_DEADLINE
+   reservation (runtime dl_runtime_us every dl_period_us, implicit deadline)
+   of each worker, see run_virtual() */
+int virtual_time = 0;
+long vt_now_ns = 0;
+
+#define VT_IDLE      0   // waiting for a push
+#define VT_BUSY      1   // running a job, till event_ns
+#define VT_THROTTLED 2   // out of budget, till event_ns
+
+typedef struct {
+  int state;
+  long event_ns;
+  job_t *p_job;
+  long runtime_left_ns;  // CBS state, as dl_params_get() would report it
+  long abs_deadline_ns;
+  long busy_ns;          // consumed budget
+  estim est;
+} vworker_t;
+
+vworker_t vworkers[MAX_NUM_CHILD];
+vworker_t *vt_cur = NULL; // worker calling rtq_pop_dl_nosync()
+
+void vt_to_ts(long ns, struct timespec *ts) {
+  ts->tv_sec = ns / 1000000000l;
+  ts->tv_nsec = ns % 1000000000l;
+}
+
+/* Current time, simulated with --virtual */
+void rtq_now(struct timespec *ts) {
+  if (virtual_time)
+    vt_to_ts(vt_now_ns, ts);
+  else
+    clock_gettime(CLOCK_MONOTONIC, ts);
+}
+
+/* Runtime left and absolute deadline (CLOCK_MONOTONIC) of the calling
+   worker's reservation, simulated with --virtual */
+void rtq_dl_params(long *runtime_left_ns, long *abs_deadline_ns) {
+  if (virtual_time) {
+    *runtime_left_ns = vt_cur->runtime_left_ns;
+    *abs_deadline_ns = vt_cur->abs_deadline_ns;
+    return;
+  }
+  dl_params_get(gettid(), runtime_left_ns, abs_deadline_ns);
+  *abs_deadline_ns = deadline_to_monotonic(*abs_deadline_ns);
+}
+
+/* Replenishment of a throttled reservation at time now_ns */
+void vt_cbs_replenish(vworker_t *w, long now_ns) {
+  while (w->runtime_left_ns <= 0) {
+    w->abs_deadline_ns += dl_period_us * 1000l;
+    w->runtime_left_ns += dl_runtime_us * 1000l;
+  }
+  if (w->abs_deadline_ns < now_ns) {
+    w->abs_deadline_ns = now_ns + dl_period_us * 1000l;
+    w->runtime_left_ns = dl_runtime_us * 1000l;
+  }
+}
+
+/* CBS wake-up rule, for a worker blocked till now_ns */
+void vt_cbs_wakeup(vworker_t *w, long now_ns) {
+  if (dl_runtime_us == 0)
+    return;
+  if (w->abs_deadline_ns < now_ns
+      || w->runtime_left_ns * (double)dl_period_us > (w->abs_deadline_ns - now_ns) * (double)dl_runtime_us) {
+    w->abs_deadline_ns = now_ns + dl_period_us * 1000l;
+    w->runtime_left_ns = dl_runtime_us * 1000l;
+  }
+}
+
+/* Runs worker w from now_ns for need_ns of CPU time, but not past stop_ns
+   (then the job notices it only once it runs again); returns the time it
+   stops, with the CPU time it got in *p_used_ns */
+long vt_cbs_run(vworker_t *w, long now_ns, long need_ns, long stop_ns, long *p_used_ns) {
+  long used_ns = 0;
+  while (used_ns < need_ns && now_ns < stop_ns) {
+    long run_ns = need_ns - used_ns;
+    if (stop_ns - now_ns < run_ns)
+      run_ns = stop_ns - now_ns;
+    if (dl_runtime_us > 0) {
+      if (w->runtime_left_ns <= 0) {
+        now_ns = lmax(now_ns, w->abs_deadline_ns);
+        vt_cbs_replenish(w, now_ns);
+        continue;
+      }
+      if (w->runtime_left_ns < run_ns)
+        run_ns = w->runtime_left_ns;
+      w->runtime_left_ns -= run_ns;
+    }
+    now_ns += run_ns;
+    used_ns += run_ns;
+  }
+  *p_used_ns = used_ns;
+  return now_ns;
+}
+
 long lceil(long a, long b) {
   return (a + b - 1) / b;
 }
@@ -217,13 +582,22 @@ job_t *rtq_pop_dl_nosync(rtqueue_t *pq) {
   if (pq->size == 0)
     goto out;
 
-  long runtime_left_ns, abs_deadline_ns;
+  knobs_t k;
+  knobs_read(&k);
+  // the online estimator (-ep) owns the percentile when enabled
+  double perc_us = estim_perc > 0 ? comp_time_perc_us : k.comp_time_perc_us;
+
+  long runtime_left_ns = 0, abs_deadline_ns = 0;
   if (dl_runtime_us > 0) {
-    dl_params_get(gettid(), &runtime_left_ns, &abs_deadline_ns);
-    abs_deadline_ns = deadline_to_monotonic(abs_deadline_ns);
+    rtq_dl_params(&runtime_left_ns, &abs_deadline_ns);
+    static __thread long last_abs_deadline_ns = 0;
+    if (abs_deadline_ns != last_abs_deadline_ns) {
+      RTQ_TRACE(RTQ_EV_CBS_PERIOD, -1, runtime_left_ns);
+      last_abs_deadline_ns = abs_deadline_ns;
+    }
   }
   struct timespec now_ts;
-  clock_gettime(CLOCK_MONOTONIC, &now_ts);
+  rtq_now(&now_ts);
 
   for (int n = 0; n < pq->size; n++) {
     dw_log("peeking at elem n=%d, size=%d\n", n, pq->size);
@@ -235,12 +609,19 @@ job_t *rtq_pop_dl_nosync(rtqueue_t *pq) {
     if (slack_ns < 0) {
       dw_log("dropping late job %d (%p)\n", (int)(p_elem - jobs), (void*)p_elem);
       check(rtq_popn_nosync(pq, n) == p_elem);
+      RTQ_TRACE(RTQ_EV_LATE_DROP, job_idx(p_elem), slack_ns);
+      if (my_wstats != NULL)
+        STAT_INC(my_wstats->late);
+      if (shm != NULL)
+        late_pending[late_npending++] = p_elem;
+      else
+        rtq_notify(p_elem, RTQ_SHM_LATE);
       n--;
       continue;
     }
-    long C_ns = comp_time_perc_us * 1000l;
+    long C_ns = perc_us * 1000l;
     int accept_job = 0;
-    if (prob_dismiss_wcet_us == 0) {
+    if (k.prob_dismiss_wcet_us == 0) {
       /* old policy: dismiss deterministically */
       long finish_time_ns;
       if (C_ns < runtime_left_ns) {
@@ -264,13 +645,13 @@ job_t *rtq_pop_dl_nosync(rtqueue_t *pq) {
     } else {
       /* new policy: dismiss with probability increasing linearly with the usable budget till job deadline going from the desired percentile to the WCET */
       long avail_ns = budget_to_deadline(runtime_left_ns, abs_deadline_ns - ts_to_ns(now_ts), slack_ns);
-      dw_log("job %d (%p) perc_ns %ld avail_ns %ld wcet_ns %ld\n", (int)(p_elem - jobs), (void*)p_elem, C_ns, avail_ns, (long)(prob_dismiss_wcet_us * 1000l));
-      if (avail_ns >= prob_dismiss_wcet_us * 1000l)
+      dw_log("job %d (%p) perc_ns %ld avail_ns %ld wcet_ns %ld\n", (int)(p_elem - jobs), (void*)p_elem, C_ns, avail_ns, (long)(k.prob_dismiss_wcet_us * 1000l));
+      if (avail_ns >= k.prob_dismiss_wcet_us * 1000l)
         /* WCET guaranteed: accept job for process */
         accept_job = 1;
       else if (avail_ns >= C_ns) {
         /* avail_ns between perc and wcet, apply probabilistic dismissal */
-        float prob = (avail_ns - C_ns) / (float)(prob_dismiss_wcet_us * 1000.0 - C_ns);
+        float prob = (avail_ns - C_ns) / (float)(k.prob_dismiss_wcet_us * 1000.0 - C_ns);
         unsigned long r = rand();
         dw_log("prob %f rand %f\n", prob, (float)r / (float)RAND_MAX);
         if ((float)r / (float)RAND_MAX < prob)
@@ -294,21 +675,60 @@ job_t *rtq_pop_dl_nosync(rtqueue_t *pq) {
   return p_job;
 }
 
-// returns true if job finished, false if dismissed
-int consume_us(job_t *p_job) {
+// returns true if job finished, false if dismissed (or aborted), with the
+// CPU time it consumed in *p_elapsed_us
+int consume_us(job_t *p_job, unsigned long *p_elapsed_us) {
   struct timespec ts_beg, ts_end;
-  unsigned long elapsed_us;
-  unsigned long curr_resp_time_us;
+  unsigned long elapsed_us = 0;
+  unsigned long curr_resp_time_us = 0;
+  int aborted = 0;
   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_beg);
   do {
-    struct timespec ts_now;
-    clock_gettime(CLOCK_MONOTONIC, &ts_now);
-    curr_resp_time_us = (ts_now.tv_sec - p_job->sent.tv_sec) * 1000000 + (ts_now.tv_nsec - p_job->sent.tv_nsec) / 1000;
+    // cheap check, as a real job body would do
+    if (abort_mode != ABORT_NONE && job_abort) {
+      aborted = 1;
+      break;
+    }
+    // with --abort dismiss the timer enforces the dismiss point
+    if (dismiss_point_us > 0 && abort_mode != ABORT_DISMISS) {
+      struct timespec ts_now;
+      clock_gettime(CLOCK_MONOTONIC, &ts_now);
+      curr_resp_time_us = (ts_now.tv_sec - p_job->sent.tv_sec) * 1000000 + (ts_now.tv_nsec - p_job->sent.tv_nsec) / 1000;
+    }
 
     clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_end);
     elapsed_us = (ts_end.tv_sec - ts_beg.tv_sec) * 1000000 + (ts_end.tv_nsec - ts_beg.tv_nsec) / 1000;
   } while (elapsed_us < p_job->C_us && (dismiss_point_us == 0 || curr_resp_time_us <= dismiss_point_us));
-  return elapsed_us >= p_job->C_us;
+  if (aborted) {
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_end);
+    elapsed_us = (ts_end.tv_sec - ts_beg.tv_sec) * 1000000 + (ts_end.tv_nsec - ts_beg.tv_nsec) / 1000;
+  }
+  *p_elapsed_us = elapsed_us;
+  return !aborted && elapsed_us >= p_job->C_us;
+}
+
+void abort_handler(int sig) {
+  (void)sig;
+  job_abort = 1;
+}
+
+/* Creates the abort timer of the calling worker, signalling its own thread */
+void abort_timer_create(timer_t *p_timer, pid_t tid) {
+  struct sigevent sev;
+  memset(&sev, 0, sizeof(sev));
+  sev.sigev_notify = SIGEV_THREAD_ID;
+  sev.sigev_signo = ABORT_SIGNAL;
+  sev.sigev_notify_thread_id = tid;
+  check(timer_create(CLOCK_MONOTONIC, &sev, p_timer) == 0, "timer_create() failed!");
+}
+
+/* Arms the abort timer at the absolute time *p_ts, or disarms it if NULL */
+void abort_timer_set(timer_t timer, const struct timespec *p_ts) {
+  struct itimerspec its;
+  memset(&its, 0, sizeof(its));
+  if (p_ts != NULL)
+    its.it_value = *p_ts;
+  timer_settime(timer, TIMER_ABSTIME, &its, NULL);
 }
 
 void sched_dl_params_overhead() {
@@ -336,9 +756,43 @@ void sched_set_deadline(unsigned long runtime_us, unsigned long deadline_us, uns
   }
 }
 
-/* Pull a job out of the JAMS shared queue */
-job_t *rtq_pop(rtqueue_t *pq) {
+/* Drop the SCHED_DEADLINE reservation of the calling thread */
+void sched_set_other() {
+  struct sched_attr attr = {
+    .size = sizeof(struct sched_attr),
+    .sched_policy = SCHED_OTHER,
+  };
+  if (sched_setattr(0, &attr, 0) < 0) {
+    perror("setattr() failed");
+  }
+}
+
+/* Pull a job out of the JAMS shared queue. With --elastic, a worker idle
+   for park_idle_us gets &park_job, unless that leaves less than
+   elastic_min active workers. */
+static inline void pop_wait_begin(void) {
+  if (my_perf != NULL)
+    rtq_perf_read(my_perf, my_wait_beg);
+}
+
+static inline void pop_wait_end(int thread_id) {
+  if (my_perf == NULL)
+    return;
+  uint64_t v[RTQ_PERF_NUM];
+  rtq_perf_read(my_perf, v);
+  rtq_perf_acc(&wperf[thread_id].wait, my_wait_beg, v);
+  for (int k = 0; k < RTQ_PERF_NUM; k++)
+    my_wait_v[k] += v[k] - my_wait_beg[k];
+}
+
+job_t *rtq_pop(rtqueue_t *pq, int thread_id) {
   job_t *p_elem = NULL;
+  struct timespec ts_idle;
+  if (elastic_min > 0) {
+    clock_gettime(CLOCK_MONOTONIC, &ts_idle);
+    ts_add_us(&ts_idle, park_idle_us);
+  }
+  RTQ_TRACE(RTQ_EV_POP_START, -1, 0);
   pthread_mutex_lock(&pq->mtx);
 
   while (!exiting) {
@@ -352,15 +806,84 @@ job_t *rtq_pop(rtqueue_t *pq) {
     if (p_elem != NULL)
       break;
 
-    pthread_cond_wait(&pq->empty, &pq->mtx);
+    if (late_npending > 0) {
+      pthread_mutex_unlock(&pq->mtx);
+      rtq_notify_late_flush();
+      pthread_mutex_lock(&pq->mtx);
+      continue;
+    }
+
+    if (elastic_min == 0 || num_active <= elastic_min) {
+      // not allowed to park: no idle timeout, just wait for a push
+      pop_wait_begin();
+      pthread_cond_wait(&pq->empty, &pq->mtx);
+      pop_wait_end(thread_id);
+      if (elastic_min > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &ts_idle);
+        ts_add_us(&ts_idle, park_idle_us);
+      }
+    } else {
+      pop_wait_begin();
+      int rv = pthread_cond_timedwait(&pq->empty, &pq->mtx, &ts_idle);
+      pop_wait_end(thread_id);
+      if (rv != ETIMEDOUT)
+        continue;
+      if (pq->size == 0) {
+        num_active--;
+        parked_ids[num_parked++] = thread_id;
+        p_elem = &park_job;
+        break;
+      }
+      // jobs queued but none feasible: stay for another idle period
+      clock_gettime(CLOCK_MONOTONIC, &ts_idle);
+      ts_add_us(&ts_idle, park_idle_us);
+    }
   }
 
   pthread_cond_signal(&pq->full);
   pthread_mutex_unlock(&pq->mtx);
+  rtq_notify_late_flush();
+  RTQ_TRACE(RTQ_EV_POP_END, job_idx(p_elem), 0);
 
   return p_elem;
 }
 
+/* Unpark all workers, so they see exiting */
+void pool_unpark_all(rtqueue_t *pq) {
+  pthread_mutex_lock(&pq->mtx);
+  while (num_parked > 0)
+    pool_unpark();
+  pthread_mutex_unlock(&pq->mtx);
+}
+
+/* Park the calling worker until rtq_push() unparks it: its reservation is
+   released meanwhile and acquired back before returning. Returns 0 if it
+   was unparked for exiting. */
+int worker_park(int thread_id, struct timespec *ts_active) {
+  struct timespec ts_now;
+  clock_gettime(CLOCK_MONOTONIC, &ts_now);
+  my_wstats->active_us += ts_sub_ns(&ts_now, ts_active) / 1000;
+  my_wstats->parks++;
+  if (dl_runtime_us > 0)
+    sched_set_other();
+
+  park_t *pk = &park[thread_id];
+  pthread_mutex_lock(&q.mtx);
+  while (!pk->wake && !exiting)
+    pthread_cond_wait(&pk->cond, &q.mtx);
+  pk->wake = 0;
+  struct timespec ts_wake = pk->wake_ts;
+  pthread_mutex_unlock(&q.mtx);
+  if (exiting)
+    return 0;
+
+  if (dl_runtime_us > 0)
+    sched_set_deadline(dl_runtime_us, dl_period_us, dl_period_us);
+  clock_gettime(CLOCK_MONOTONIC, ts_active);
+  hist_add(&my_wstats->spinup, ts_sub_ns(ts_active, &ts_wake) / 1000);
+  return 1;
+}
+
 void rtq_wait_until_empty(rtqueue_t *pq) {
   while (pq->size > 0) {
     dw_log("wait_until_empty(): size=%d\n", pq->size);
@@ -388,6 +911,10 @@ void *worker(void *arg) {
   int thread_id = pinfo - child; // just 0, 1, ...; not a Linux TID
   pinfo->tid = gettid();
 
+  char trace_name[32];
+  snprintf(trace_name, sizeof(trace_name), "worker %d", thread_id);
+  check(rtq_trace_thread(trace_name, pinfo->tid), "rtq_trace_thread() failed!");
+
   // workers are pinned to affinity_cpu + 1, + 2, etc...
   if (affinity_cpu != -1)
     set_affinity(affinity_cpu + thread_id + 1);
@@ -402,28 +929,120 @@ void *worker(void *arg) {
   if (estim_perc > 0)
     estim_init(&est, estim_perc);
 
+  my_wstats = &wstats[thread_id];
+  my_done_ring = &done_rings[thread_id];
+  hist_init(&my_wstats->elapsed);
+  hist_init(&my_wstats->queue);
+  hist_init(&my_wstats->slack);
+  hist_init(&my_wstats->spinup);
+  hist_init(&my_wstats->abort_lat);
+
+  timer_t abort_timer;
+  if (abort_mode != ABORT_NONE)
+    abort_timer_create(&abort_timer, pinfo->tid);
+  pthread_cond_init(&park[thread_id].cond, NULL);
+
+  rtq_perf_t perf = { .leader = -1 };
+  uint64_t pv_beg[RTQ_PERF_NUM], pv_end[RTQ_PERF_NUM];
+  if (perf_counters) {
+    rtq_perf_open(&perf);
+    wperf[thread_id].mode = perf.mode;
+    my_perf = &perf;
+  }
+
+  if (mem_lock)
+    rtq_mem_prefault_stack();
+
   pthread_barrier_wait(&barrier);
 
+  long minflt0, majflt0;
+  rtq_mem_faults(&minflt0, &majflt0);
+  struct timespec ts_active;
+  clock_gettime(CLOCK_MONOTONIC, &ts_active);
+  int active = 1;
+
   for (int i = 0; !exiting; i++) {
     struct timespec ts_beg;
+    if (perf_counters) {
+      memset(my_wait_v, 0, sizeof(my_wait_v));
+      rtq_perf_read(&perf, pv_beg);
+    }
     if (measure_overheads)
       clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_beg);
 
-    job_t *p_job = rtq_pop(&q);
+    job_t *p_job = rtq_pop(&q, thread_id);
 
+    if (perf_counters) {
+      rtq_perf_read(&perf, pv_end);
+      for (int k = 0; k < RTQ_PERF_NUM; k++)
+        pv_end[k] -= my_wait_v[k];
+      rtq_perf_acc(&wperf[thread_id].pop, pv_beg, pv_end);
+    }
     if (measure_overheads) {
       struct timespec ts_end;
       clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_end);
-      assert(pop_elapsed_num[thread_id] < MAX_NUM_REQS);
-      pop_elapsed_ns[thread_id][pop_elapsed_num[thread_id]++] = (ts_end.tv_sec - ts_beg.tv_sec) * 1000000000l + (ts_end.tv_nsec - ts_beg.tv_nsec);
+      // parks can pop more than num_reqs times: keep the first samples
+      if (wperf[thread_id].pop_elapsed_num < num_reqs)
+        pop_elapsed_ns[thread_id][wperf[thread_id].pop_elapsed_num++] = (ts_end.tv_sec - ts_beg.tv_sec) * 1000000000l + (ts_end.tv_nsec - ts_beg.tv_nsec);
     }
 
     if (p_job == NULL || p_job == &dummy)
       break;
 
-    if (!consume_us(p_job)) {
+    if (p_job == &park_job) {
+      if (!worker_park(thread_id, &ts_active)) {
+        active = 0;
+        break;
+      }
+      continue;
+    }
+
+    RTQ_TRACE(RTQ_EV_JOB_START, job_idx(p_job), p_job->C_us);
+    struct timespec ts_start;
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    hist_add(&my_wstats->queue, ts_sub_ns(&ts_start, &p_job->sent) / 1000);
+    struct timespec ts_abort;
+    if (abort_mode != ABORT_NONE) {
+      if (abort_mode == ABORT_DEADLINE) {
+        ts_abort = p_job->deadline_ts;
+      } else {
+        ts_abort = p_job->sent;
+        ts_add_us(&ts_abort, dismiss_point_us);
+      }
+      abort_timer_set(abort_timer, &ts_abort);
+    }
+    if (perf_counters)
+      rtq_perf_read(&perf, pv_beg);
+    unsigned long cpu_us;
+    int finished = consume_us(p_job, &cpu_us);
+    if (perf_counters) {
+      rtq_perf_read(&perf, pv_end);
+      rtq_perf_acc(&wperf[thread_id].job, pv_beg, pv_end);
+    }
+    if (abort_mode != ABORT_NONE) {
+      // a timer expiring once the job is over does not abort it
+      int aborted = !finished && job_abort;
+      abort_timer_set(abort_timer, NULL);
+      // clear after disarming: the timer might expire right after the job
+      job_abort = 0;
+      if (aborted) {
+        struct timespec ts_now;
+        clock_gettime(CLOCK_MONOTONIC, &ts_now);
+        p_job->elapsed_us = 0;
+        RTQ_TRACE(RTQ_EV_ABORT, job_idx(p_job), cpu_us);
+        STAT_INC(my_wstats->aborted);
+        my_wstats->aborted_us += cpu_us;
+        hist_add(&my_wstats->abort_lat, ts_sub_ns(&ts_now, &ts_abort) / 1000);
+        rtq_notify(p_job, RTQ_SHM_DISMISSED);
+        continue;
+      }
+    }
+    if (!finished) {
       // technically unneeded, just remarking this will job be counted as dismissed
       p_job->elapsed_us = 0;
+      RTQ_TRACE(RTQ_EV_DISMISS, job_idx(p_job), 0);
+      STAT_INC(my_wstats->dismissed);
+      rtq_notify(p_job, RTQ_SHM_DISMISSED);
       continue;
     }
 
@@ -439,26 +1058,543 @@ void *worker(void *arg) {
     clock_gettime(CLOCK_MONOTONIC, &ts_end);
     p_job->elapsed_us = (ts_end.tv_sec - p_job->sent.tv_sec) * 1000000 + (ts_end.tv_nsec - p_job->sent.tv_nsec) / 1000;
     assert(p_job->elapsed_us >= p_job->C_us - 1); // tolerate 1us lost
+    RTQ_TRACE(RTQ_EV_JOB_FINISH, job_idx(p_job), p_job->elapsed_us);
+    long slack_us = ts_sub_ns(&p_job->deadline_ts, &ts_end) / 1000;
+    STAT_INC(my_wstats->done);
+    if (slack_us < 0)
+      STAT_INC(my_wstats->missed);
+    hist_add(&my_wstats->elapsed, p_job->elapsed_us);
+    hist_add(&my_wstats->slack, slack_us);
+    rtq_notify(p_job, RTQ_SHM_DONE);
   }
+
+  if (abort_mode != ABORT_NONE)
+    timer_delete(abort_timer);
+
+  struct timespec ts_end;
+  clock_gettime(CLOCK_MONOTONIC, &ts_end);
+  if (active)
+    my_wstats->active_us += ts_sub_ns(&ts_end, &ts_active) / 1000;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_end);
+  my_wstats->cpu_us = ts_to_us(ts_end);
+  rtq_mem_faults(&my_wstats->minflt, &my_wstats->majflt);
+  my_wstats->minflt -= minflt0;
+  my_wstats->majflt -= majflt0;
+
+  if (perf_counters)
+    rtq_perf_close(&perf);
   return 0;
 }
 
+/* Job for request j: jobs[j], or a free slot of the --pool */
+job_t *job_alloc(long j) {
+  job_t *p_job = pool_size > 0 ? NULL : &jobs[j];
+  if (pool_size > 0) {
+    if (pool_cached == 0) {
+      job_t *p_free;
+      while ((p_free = job_ring_get(&free_ring)) != NULL)
+        pool_cache[pool_cached++] = p_free;
+      if (pool_cached == 0) {
+        // all slots in flight: spin a little, then sleep as the collector
+        // recycles them in batches
+        pool_stalls++;
+        for (long idle = 0; (p_free = job_ring_get(&free_ring)) == NULL; idle++)
+          rtq_shm_backoff(idle);
+        pool_cache[pool_cached++] = p_free;
+      }
+    }
+    p_job = pool_cache[--pool_cached];
+  }
+  p_job->id = j;
+  p_job->stream = -1;
+  return p_job;
+}
+
+/* Push request j into the queue, recording the push overhead and outcome */
+void push_job(job_t *p_job, long j) {
+  struct timespec ts_beg;
+  if (measure_overheads)
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_beg);
+
+  // set before pushing: once in the queue, the job belongs to the workers
+  p_job->elapsed_us = 0;
+  if (rtq_push(&q, p_job)) {
+    STAT_INC(push_accepted);
+  } else {
+    p_job->elapsed_us = -1;
+    STAT_INC(push_rejected);
+    rtq_notify(p_job, RTQ_SHM_REJECTED);
+  }
+
+  if (measure_overheads) {
+    struct timespec ts_end;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_end);
+    push_elapsed_ns[j] = (ts_end.tv_sec - ts_beg.tv_sec) * 1000000000l + (ts_end.tv_nsec - ts_beg.tv_nsec);
+  }
+
+  if (j == 0 || (j-1) * 10l / num_reqs < j * 10l / num_reqs) {
+    fprintf(stderr, "%ld%%...", j * 100l / num_reqs);
+    fflush(stderr);
+  }
+}
+
+/* Ingest thread for --shm: busy-polls the submit ring (no syscalls on the
+   fast path) and pushes num_reqs client jobs, in place of the generator.
+   Stops early, lowering num_reqs, if the client ends the stream or dies. */
+void *ingest(void *arg) {
+  (void)arg;
+  if (affinity_cpu != -1)
+    set_affinity(affinity_cpu);
+  check(rtq_trace_thread("ingest", gettid()), "rtq_trace_thread() failed!");
+  my_done_ring = &done_rings[num_child];
+  if (mem_lock)
+    rtq_mem_prefault_stack();
+
+  long minflt0, majflt0;
+  rtq_mem_faults(&minflt0, &majflt0);
+  long idle = 0;
+  long j = 0;
+  while (j < num_reqs) {
+    rtq_shm_req_t req;
+    int ended = rtq_shm_ended(shm);
+    if (!rtq_shm_poll_submit(shm, &req)) {
+      if (ended)
+        break;
+      idle++;
+      if (idle % RTQ_SHM_LIVENESS_POLLS == 0 && !rtq_shm_client_alive(shm)) {
+        fprintf(stderr, "ingest: client exited without ending the stream\n");
+        break;
+      }
+      rtq_shm_backoff(idle);
+      continue;
+    }
+    idle = 0;
+    job_t *p_job = job_alloc(j);
+    if (j == 0)
+      ref_sent_us = ts_to_us(req.sent);
+    p_job->sent = req.sent;
+    p_job->C_us = req.C_us;
+    p_job->deadline_ts = req.sent;
+    ts_add_us(&p_job->deadline_ts, req.deadline_us);
+    p_job->shm_id = req.id;
+
+    push_job(p_job, j);
+    j++;
+  }
+  if (j < num_reqs) {
+    printf("ingest: stream ended after %ld of %ld jobs\n", j, num_reqs);
+    num_reqs = j;
+  }
+  rtq_mem_faults(&gen_minflt, &gen_majflt);
+  gen_minflt -= minflt0;
+  gen_majflt -= majflt0;
+  return NULL;
+}
+
+/* --pool collector thread: streams out the result of each settled job, in
+   completion order, and recycles its slot */
+RunningStats pool_rt_stats;
+long pool_rejected = 0;
+int collector_stop = 0;
+
+void *collector(void *arg) {
+  (void)arg;
+  if (mem_lock)
+    rtq_mem_prefault_stack();
+  stats_init(&pool_rt_stats);
+  for (;;) {
+    // a pass that starts after the stop request and finds nothing is the last
+    int stop = __atomic_load_n(&collector_stop, __ATOMIC_ACQUIRE);
+    long got = 0;
+    for (int i = 0; i <= num_child; i++) {
+      job_t *p_job;
+      while ((p_job = job_ring_get(&done_rings[i])) != NULL) {
+        if (dump_requests)
+          printf("request %ld sent_us %lu C_us %u elapsed_us %d\n", p_job->id, ts_to_us(p_job->sent) - ref_sent_us, p_job->C_us, (int)p_job->elapsed_us);
+        if (p_job->elapsed_us > 0)
+          stats_add(&pool_rt_stats, p_job->elapsed_us);
+        pool_rejected += p_job->elapsed_us < 0;
+        if (p_job->stream >= 0)
+          rtq_workload_account(&workload, p_job->stream, p_job->elapsed_us);
+        check(job_ring_put(&free_ring, p_job));
+        got++;
+      }
+    }
+    if (got == 0) {
+      if (stop)
+        break;
+      usleep(1000);
+    }
+  }
+  return NULL;
+}
+
+/* --controller: closed-loop AIMD tuning of the admission knobs. Every
+   ctl_period_ms it measures, over the last CTL_WINDOWS periods, the ratio
+   of jobs completed by their deadline among the accepted ones that were
+   resolved (completed, dismissed or dropped late), and moves an admission
+   level L in ]0, 1]: L *= ctl_beta when the ratio is under ctl_target
+   (then holds for a whole window, so the same misses are not punished
+   twice), L += ctl_alpha otherwise. L = 1 is the command-line setting,
+   i.e. the most permissive one; lower levels scale the queue thresholds
+   down and the drop probability and the percentile/WCET estimates up. */
+double ctl_target = 0;            // target on-time ratio, 0: no controller
+unsigned long ctl_period_ms = 100;
+double ctl_alpha = 0.05;
+double ctl_beta = 0.7;
+#define CTL_WINDOWS 5
+int ctl_stop = 0;
+
+typedef struct {
+  long accepted, rejected, done, missed, dismissed, late;
+} ctl_sample_t;
+
+void ctl_sample(ctl_sample_t *c) {
+  memset(c, 0, sizeof(*c));
+  c->accepted = STAT_GET(push_accepted);
+  c->rejected = STAT_GET(push_rejected);
+  for (int i = 0; i < num_child; i++) {
+    c->done += STAT_GET(wstats[i].done);
+    c->missed += STAT_GET(wstats[i].missed);
+    c->dismissed += STAT_GET(wstats[i].dismissed) + STAT_GET(wstats[i].aborted);
+    c->late += STAT_GET(wstats[i].late);
+  }
+}
+
+void ctl_apply(const knobs_t *base, double level, knobs_t *k) {
+  *k = *base;
+  k->push_drop_size = lmax(1, lround(base->push_drop_size * level));
+  k->red_min_th = base->red_min_th * level;
+  k->red_max_th = base->red_max_th * level;
+  k->red_max_p = fmin(1.0, base->red_max_p / level);
+  k->comp_time_perc_us = base->comp_time_perc_us * (2.0 - level);
+  if (base->prob_dismiss_wcet_us > 0)
+    k->prob_dismiss_wcet_us = fmax(base->prob_dismiss_wcet_us * (2.0 - level), k->comp_time_perc_us);
+}
+
+void *controller(void *arg) {
+  (void)arg;
+  if (mem_lock)
+    rtq_mem_prefault_stack();
+  knobs_t base, k;
+  knobs_read(&base);
+  double level = 1.0;
+  int hold = 0;
+
+  ctl_sample_t win[CTL_WINDOWS + 1];
+  ctl_sample(&win[0]);
+  long n = 1;
+
+  struct timespec ts_beg, ts_next;
+  clock_gettime(CLOCK_MONOTONIC, &ts_beg);
+  ts_next = ts_beg;
+  while (!__atomic_load_n(&ctl_stop, __ATOMIC_RELAXED)) {
+    ts_add_us(&ts_next, ctl_period_ms * 1000.0);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts_next, NULL);
+
+    ctl_sample_t cur, old = win[(n >= CTL_WINDOWS ? n - CTL_WINDOWS : 0) % (CTL_WINDOWS + 1)];
+    ctl_sample(&cur);
+    win[n % (CTL_WINDOWS + 1)] = cur;
+    n++;
+
+    long done = cur.done - old.done;
+    long missed = cur.missed - old.missed;
+    long resolved = done + cur.dismissed - old.dismissed + cur.late - old.late;
+    double ratio = resolved > 0 ? (done - missed) / (double)resolved : 1.0;
+
+    const char *action = "hold";
+    if (hold > 0) {
+      hold--;
+    } else if (ratio < ctl_target) {
+      level = fmax(0.01, level * ctl_beta);
+      hold = CTL_WINDOWS - 1;
+      action = "decrease";
+    } else if (level < 1.0) {
+      level = fmin(1.0, level + ctl_alpha);
+      action = "increase";
+    }
+    ctl_apply(&base, level, &k);
+    knobs_publish(&k);
+
+    printf("controller: t_ms %ld resolved %ld on-time %.4f accepted %ld rejected %ld %s level %.3f pds %d min_th %.1f max_th %.1f max_p %.3f perc_us %.0f wcet_us %.0f\n",
+           ts_sub_ns(&ts_next, &ts_beg) / 1000000, resolved, ratio,
+           cur.accepted - old.accepted, cur.rejected - old.rejected, action, level,
+           k.push_drop_size, k.red_min_th, k.red_max_th, k.red_max_p,
+           k.comp_time_perc_us, k.prob_dismiss_wcet_us);
+  }
+  return NULL;
+}
+
 pd_spec_t pd_comp_time_us;
 pd_spec_t pd_period_us;
 pd_spec_t pd_deadline_us;
 unsigned long seed;
 dl_params_type_t dlpar_type = DL_PARAMS_AUTO;
 
+/* Runs the workers and the job generator (or --shm ingestion) in real
+   time, till all workers have exited */
+void run_live(struct timespec *p_run_beg, struct timespec *p_run_end) {
+  pthread_barrier_init(&barrier, NULL, num_child + 1);
+
+  for (int i = 0; i < num_child; i++) {
+    pthread_create(&child[i].pthr, NULL, &worker, &child[i]);
+  }
+
+  pthread_barrier_wait(&barrier);
+
+  clock_gettime(CLOCK_MONOTONIC, p_run_beg);
+
+  pthread_t ctl_thr;
+  if (ctl_target > 0)
+    pthread_create(&ctl_thr, NULL, &controller, NULL);
+
+  pthread_t coll_thr;
+  if (pool_size > 0)
+    pthread_create(&coll_thr, NULL, &collector, NULL);
+
+  if (shm != NULL) {
+    pthread_t ingest_thr;
+    pthread_create(&ingest_thr, NULL, &ingest, NULL);
+    pthread_join(ingest_thr, NULL);
+  } else {
+    struct timespec ts_next;
+    rtq_pace_init(&pace, pace_mode);
+    my_done_ring = &done_rings[num_child];
+    long minflt0, majflt0;
+    rtq_mem_faults(&minflt0, &majflt0);
+    clock_gettime(CLOCK_MONOTONIC, &ts_next);
+    struct timespec ts_wl_beg = ts_next;
+    for (long j = 0; j < num_reqs; j++) {
+      // --workload: the streams give absolute release times
+      long rel_us;
+      double C_us;
+      int stream = workload.n > 0 ? rtq_workload_next(&workload, &rel_us, &C_us) : -1;
+      if (stream >= 0) {
+        ts_next = ts_wl_beg;
+        ts_add_us(&ts_next, rel_us);
+        rtq_pace_until(&pace, &ts_next);
+      }
+      job_t *p_job = job_alloc(j);
+      clock_gettime(CLOCK_MONOTONIC, &p_job->sent);
+      if (j == 0)
+        ref_sent_us = ts_to_us(p_job->sent);
+      p_job->stream = stream;
+      p_job->C_us = ceil(stream >= 0 ? C_us : pd_sample(&pd_comp_time_us));
+      //printf("C_us=%u\n", p_job->C_us);
+      p_job->deadline_ts = p_job->sent;
+      ts_add_us(&p_job->deadline_ts, stream >= 0 ? workload.s[stream].deadline_us : pd_sample(&pd_deadline_us));
+
+      push_job(p_job, j);
+
+      if (stream < 0) {
+        ts_add_us(&ts_next, pd_sample(&pd_period_us));
+        rtq_pace_until(&pace, &ts_next);
+      }
+    }
+    rtq_mem_faults(&gen_minflt, &gen_majflt);
+    gen_minflt -= minflt0;
+    gen_majflt -= majflt0;
+  }
+  fprintf(stderr, "\n");
+
+  printf("Waiting for empty queue...\n");
+  rtq_wait_until_empty(&q);
+
+  if (ctl_target > 0) {
+    __atomic_store_n(&ctl_stop, 1, __ATOMIC_RELAXED);
+    pthread_join(ctl_thr, NULL);
+  }
+
+  printf("Terminating and joining workers...\n");
+
+  exiting = 1;
+
+  // cause exit of worker threads as they pop &dummy out of q
+  for (int i = 0; i < num_child; i++)
+    // repeat in case push doesn't succeed (full queue or dismissed job)
+    while (!rtq_push(&q, &dummy))
+      usleep(1000);
+  pool_unpark_all(&q);
+
+  for (int i = 0; i < num_child; i++) {
+    pthread_join(child[i].pthr, NULL);
+  }
+  clock_gettime(CLOCK_MONOTONIC, p_run_end);
+
+  if (pool_size > 0) {
+    __atomic_store_n(&collector_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(coll_thr, NULL);
+  }
+}
+
+/* Process one job on virtual worker w, from the current virtual time till
+   it completes or gets dismissed/aborted, and record its outcome at the
+   time it stops, as worker() does */
+void vt_exec(vworker_t *w, job_t *p_job) {
+  long sent_ns = ts_to_ns(p_job->sent);
+  long start_ns = vt_now_ns;
+  long stop_ns = LONG_MAX;
+  if (abort_mode == ABORT_DEADLINE)
+    stop_ns = ts_to_ns(p_job->deadline_ts);
+  if (dismiss_point_us > 0 && (abort_mode != ABORT_DEADLINE || sent_ns + dismiss_point_us * 1000l < stop_ns))
+    stop_ns = sent_ns + dismiss_point_us * 1000l;
+
+  long used_ns;
+  long end_ns = vt_cbs_run(w, start_ns, p_job->C_us * 1000l, stop_ns, &used_ns);
+  w->busy_ns += used_ns;
+  w->event_ns = end_ns;
+  w->p_job = p_job;
+
+  hist_add(&my_wstats->queue, (start_ns - sent_ns) / 1000);
+  if (used_ns < p_job->C_us * 1000l) {
+    p_job->elapsed_us = 0;
+    if (abort_mode != ABORT_NONE) {
+      my_wstats->aborted++;
+      my_wstats->aborted_us += used_ns / 1000;
+      hist_add(&my_wstats->abort_lat, lmax(0, end_ns - stop_ns) / 1000);
+    } else {
+      my_wstats->dismissed++;
+    }
+    return;
+  }
+
+  if (estim_perc > 0) {
+    estim_add_sample(&w->est, p_job->C_us);
+    comp_time_perc_us = estim_get_quantile(&w->est);
+  }
+  p_job->elapsed_us = (end_ns - sent_ns) / 1000;
+  long slack_us = (ts_to_ns(p_job->deadline_ts) - end_ns) / 1000;
+  my_wstats->done++;
+  if (slack_us < 0)
+    my_wstats->missed++;
+  hist_add(&my_wstats->elapsed, p_job->elapsed_us);
+  hist_add(&my_wstats->slack, slack_us);
+}
+
+/* Idle worker w looks for a job at the current virtual time */
+void vt_pop(vworker_t *w) {
+  vt_cur = w;
+  my_wstats = &wstats[w - vworkers];
+  if (w->state == VT_IDLE)
+    vt_cbs_wakeup(w, vt_now_ns);
+  job_t *p_job = pop_feasible_jobs ? rtq_pop_dl_nosync(&q) : rtq_pop_nosync(&q);
+  if (p_job == NULL) {
+    w->state = VT_IDLE;
+    return;
+  }
+  w->state = VT_BUSY;
+  vt_exec(w, p_job);
+}
+
+/*
+ * --virtual: discrete-event simulation of the same run. Jobs are generated
+ * as in run_live(), at their ideal release times, and go through the same
+ * rtq_push() and rtq_pop_nosync()/rtq_pop_dl_nosync(), which read the
+ * simulated clock and the CBS state of the popping worker. Each worker runs
+ * on its own core under a user-space model of its SCHED_DEADLINE
+ * reservation; queue operations take no time. Idle workers try to pop on
+ * every push, like the ones woken by the broadcast on q.empty.
+ */
+void run_virtual(struct timespec *p_run_beg, struct timespec *p_run_end) {
+  for (int i = 0; i < num_child; i++) {
+    vworker_t *w = &vworkers[i];
+    memset(w, 0, sizeof(*w));
+    w->state = VT_IDLE;
+    w->runtime_left_ns = dl_runtime_us * 1000l;
+    w->abs_deadline_ns = dl_period_us * 1000l;
+    if (estim_perc > 0)
+      estim_init(&w->est, estim_perc);
+    hist_init(&wstats[i].elapsed);
+    hist_init(&wstats[i].queue);
+    hist_init(&wstats[i].slack);
+    hist_init(&wstats[i].spinup);
+    hist_init(&wstats[i].abort_lat);
+  }
+  vt_now_ns = 0;
+  vt_to_ts(vt_now_ns, p_run_beg);
+
+  long next_push_ns = 0;
+  long j = 0;
+  if (workload.n > 0)
+    next_push_ns = rtq_workload_peek(&workload) * 1000;
+  for (;;) {
+    // earliest worker event, ties to the lowest index
+    vworker_t *w_next = NULL;
+    for (int i = 0; i < num_child; i++)
+      if (vworkers[i].state != VT_IDLE && (w_next == NULL || vworkers[i].event_ns < w_next->event_ns))
+        w_next = &vworkers[i];
+
+    if (j < num_reqs && (w_next == NULL || next_push_ns < w_next->event_ns)) {
+      vt_now_ns = next_push_ns;
+      long rel_us;
+      double C_us;
+      int stream = workload.n > 0 ? rtq_workload_next(&workload, &rel_us, &C_us) : -1;
+      job_t *p_job = job_alloc(j);
+      vt_to_ts(vt_now_ns, &p_job->sent);
+      p_job->stream = stream;
+      p_job->C_us = ceil(stream >= 0 ? C_us : pd_sample(&pd_comp_time_us));
+      p_job->deadline_ts = p_job->sent;
+      ts_add_us(&p_job->deadline_ts, stream >= 0 ? workload.s[stream].deadline_us : pd_sample(&pd_deadline_us));
+
+      push_job(p_job, j);
+      j++;
+
+      if (stream >= 0)
+        next_push_ns = rtq_workload_peek(&workload) * 1000;
+      else
+        next_push_ns += pd_sample(&pd_period_us) * 1000;
+      for (int i = 0; i < num_child && q.size > 0; i++)
+        if (vworkers[i].state == VT_IDLE)
+          vt_pop(&vworkers[i]);
+      if (j == num_reqs) {
+        fprintf(stderr, "\n");
+        printf("Waiting for empty queue...\n");
+      }
+    } else if (w_next != NULL) {
+      vt_now_ns = w_next->event_ns;
+      if (w_next->state == VT_BUSY && dl_runtime_us > 0 && w_next->runtime_left_ns <= 0) {
+        // budget exhausted right at completion: throttled till the replenishment
+        w_next->state = VT_THROTTLED;
+        w_next->event_ns = w_next->abs_deadline_ns;
+        continue;
+      }
+      if (w_next->state == VT_THROTTLED)
+        vt_cbs_replenish(w_next, vt_now_ns);
+      vt_pop(w_next);
+    } else if (q.size > 0) {
+      // nobody takes the jobs left: poll again, as rtq_wait_until_empty() does
+      vt_now_ns += 100000000l;
+      for (int i = 0; i < num_child && q.size > 0; i++)
+        vt_pop(&vworkers[i]);
+    } else {
+      break;
+    }
+  }
+  printf("Terminating and joining workers...\n");
+
+  for (int i = 0; i < num_child; i++) {
+    wstats[i].active_us = vt_now_ns / 1000;
+    wstats[i].cpu_us = vworkers[i].busy_ns / 1000;
+  }
+  my_wstats = NULL;
+  vt_cur = NULL;
+  vt_to_ts(vt_now_ns, p_run_end);
+}
+
+/* rtq_bench.c includes this file with RTQ_NO_MAIN to drive the queue
+   primitives directly */
+#ifndef RTQ_NO_MAIN
 int main(int argc, char *argv[]) {
   pd_comp_time_us = pd_build_fixed(1000);
   pd_period_us = pd_build_fixed(10000);
   pd_deadline_us = pd_build_fixed(10000);
   seed = time(NULL);
+  int jobs_given = 0;
 
   argc--;  argv++;
   while (argc > 0) {
     if (strcmp(*argv, "-h") == 0 || strcmp(*argv, "--help") == 0) {
-      printf("Usage: rtqueue [-h|--help] [-t|--threads num_threads] [-a|--set-affinity cpu] [-j|--jobs num_jobs] [-c|--comp-time val|distrib] [-p|--period val|distrib] [-d|--deadline val|distrib] [-dr|--dl-runtime us] [-dp|--dl-period us] [-s|--seed val] [-ft|--fine-tune] [-pds|--push-drop-size queue_size] [-%%|--percentile perc_us] [-pd-wcet|--prob-dismiss-wcet us] [-ep|--estimate-percentile val] [-u|--utilization per_cpu_val] [-dlp|--dl-params auto|getattr|kmod|proc] [-o|--overheads] [--dismiss-point us]\n");
+      printf("Usage: rtqueue [-h|--help] [-t|--threads num_threads] [-a|--set-affinity cpu] [-j|--jobs num_jobs] [-c|--comp-time val|distrib] [-p|--period val|distrib] [-d|--deadline val|distrib] [-dr|--dl-runtime us] [-dp|--dl-period us] [-s|--seed val] [-ft|--fine-tune] [-pds|--push-drop-size queue_size] [-%%|--percentile perc_us] [-pd-wcet|--prob-dismiss-wcet us] [-ep|--estimate-percentile val] [-u|--utilization per_cpu_val] [-dlp|--dl-params auto|getattr|kmod|proc] [-o|--overheads] [--perf] [-nr|--no-requests] [--controller target_ratio] [--ctl-period ms] [--abort deadline|dismiss] [--virtual] [--pacing sleep|hybrid|spin] [--pool num_jobs] [--elastic min_threads] [--park-idle us] [--unpark-th jobs_per_thread] [--dismiss-point us] [--workload trace:period_us:deadline_us] [--mlock] [--hugepages] [--stats file.csv] [--shm name] [--trace file.json]\n");
       exit(EXIT_SUCCESS);
     } else if (strcmp(*argv, "-t") == 0 || strcmp(*argv, "--threads") == 0) {
       argc--;  argv++;
@@ -472,8 +1608,9 @@ int main(int argc, char *argv[]) {
     } else if (strcmp(*argv, "-j") == 0 || strcmp(*argv, "--jobs") == 0) {
       argc--;  argv++;
       check(argc > 0);
-      check(sscanf(*argv, "%d", &num_reqs) == 1);
-      check(num_reqs > 0 && num_reqs < MAX_NUM_REQS);
+      check(sscanf(*argv, "%ld", &num_reqs) == 1);
+      check(num_reqs > 0);
+      jobs_given = 1;
     } else if (strcmp(*argv, "-dr") == 0 || strcmp(*argv, "--dl-runtime") == 0) {
       argc--;  argv++;
       check(argc > 0);
@@ -525,6 +1662,63 @@ int main(int argc, char *argv[]) {
       fine_tune = 1;
     } else if (strcmp(*argv, "-o") == 0 || strcmp(*argv, "--overheads") == 0) {
       measure_overheads = 1;
+    } else if (strcmp(*argv, "--perf") == 0) {
+      perf_counters = 1;
+    } else if (strcmp(*argv, "--controller") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      check(sscanf(*argv, "%lf", &ctl_target) == 1);
+      check(ctl_target > 0.0 && ctl_target <= 1.0, "The controller target must be in the range ]0, 1.0]\n");
+    } else if (strcmp(*argv, "--ctl-period") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      check(sscanf(*argv, "%lu", &ctl_period_ms) == 1 && ctl_period_ms > 0);
+    } else if (strcmp(*argv, "--abort") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      if (strcmp(*argv, "deadline") == 0)
+        abort_mode = ABORT_DEADLINE;
+      else if (strcmp(*argv, "dismiss") == 0)
+        abort_mode = ABORT_DISMISS;
+      else {
+        fprintf(stderr, "Wrong argument to --abort option: %s\n", argv[0]);
+        exit(1);
+      }
+    } else if (strcmp(*argv, "--pacing") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      if (strcmp(*argv, "sleep") == 0)
+        pace_mode = RTQ_PACE_SLEEP;
+      else if (strcmp(*argv, "hybrid") == 0)
+        pace_mode = RTQ_PACE_HYBRID;
+      else if (strcmp(*argv, "spin") == 0)
+        pace_mode = RTQ_PACE_SPIN;
+      else {
+        fprintf(stderr, "Wrong argument to --pacing option: %s\n", argv[0]);
+        exit(1);
+      }
+    } else if (strcmp(*argv, "--pool") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      check(sscanf(*argv, "%d", &pool_size) == 1 && pool_size > 0);
+    } else if (strcmp(*argv, "--virtual") == 0) {
+      virtual_time = 1;
+    } else if (strcmp(*argv, "--elastic") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      check(sscanf(*argv, "%d", &elastic_min) == 1 && elastic_min > 0);
+    } else if (strcmp(*argv, "--park-idle") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      double value;
+      check(sscanf_unit(*argv, "%lf", &value, 1) == 1 && value > 0);
+      park_idle_us = value;
+    } else if (strcmp(*argv, "--unpark-th") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      check(sscanf(*argv, "%lf", &unpark_th) == 1 && unpark_th >= 0);
+    } else if (strcmp(*argv, "-nr") == 0 || strcmp(*argv, "--no-requests") == 0) {
+      dump_requests = 0;
     } else if (strcmp(*argv, "-s") == 0 || strcmp(*argv, "--seed") == 0) {
       argc--;  argv++;
       check(argc > 0);
@@ -550,6 +1744,36 @@ int main(int argc, char *argv[]) {
       double value;
       check(sscanf_unit(*argv, "%lf", &value, 1) == 1);
       dismiss_point_us = value;
+    } else if (strcmp(*argv, "--workload") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      // trace:period:deadline, the trace path may contain ':'
+      char *p_dl = strrchr(*argv, ':');
+      check(p_dl != NULL && p_dl != *argv, "--workload expects trace:period_us:deadline_us\n");
+      *p_dl = '\0';
+      char *p_per = strrchr(*argv, ':');
+      check(p_per != NULL && p_per != *argv, "--workload expects trace:period_us:deadline_us\n");
+      *p_per = '\0';
+      double period, deadline;
+      check(sscanf_unit(p_per + 1, "%lf", &period, 1) == 1 && period > 0);
+      check(sscanf_unit(p_dl + 1, "%lf", &deadline, 1) == 1 && deadline > 0);
+      check(rtq_workload_add(&workload, *argv, period, deadline), "too many --workload streams\n");
+    } else if (strcmp(*argv, "--mlock") == 0) {
+      mem_lock = 1;
+    } else if (strcmp(*argv, "--hugepages") == 0) {
+      mem_huge = 1;
+    } else if (strcmp(*argv, "--stats") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      stats_path = *argv;
+    } else if (strcmp(*argv, "--shm") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      shm_name = *argv;
+    } else if (strcmp(*argv, "--trace") == 0) {
+      argc--;  argv++;
+      check(argc > 0);
+      trace_path = *argv;
     } else {
       fprintf(stderr, "Unknown option: %s\n", *argv);
       exit(1);
@@ -557,15 +1781,25 @@ int main(int argc, char *argv[]) {
     argc--;  argv++;
   }
 
-  check(dl_params_init(dlpar_type) == 0, "dl_params_init() failed!");
+  if (!virtual_time)
+    check(dl_params_init(dlpar_type) == 0, "dl_params_init() failed!");
 
   if (isnan(u_tot))
     u_tot = dl_runtime_us / (double)dl_period_us;
 
+  // --workload: all the jobs of the traces, or the first -j ones
+  if (workload.n > 0) {
+    check(shm_name == NULL, "--workload does not support --shm\n");
+    long wl_jobs = rtq_workload_open(&workload);
+    check(wl_jobs > 0, "no jobs in the --workload traces\n");
+    if (!jobs_given || wl_jobs < num_reqs)
+      num_reqs = wl_jobs;
+  }
+
   printf("Options:\n");
   printf("   threads: %d\n", num_child);
   printf("  affinity: %d\n", affinity_cpu);
-  printf("      jobs: %d\n", num_reqs);
+  printf("      jobs: %ld\n", num_reqs);
   printf(" comp-time: %s us\n", pd_str(&pd_comp_time_us));
   printf("    period: %s us\n", pd_str(&pd_period_us));
   printf("  deadline: %s us\n", pd_str(&pd_deadline_us));
@@ -579,9 +1813,23 @@ int main(int argc, char *argv[]) {
   printf("     u-tot: %g\n", u_tot);
   printf(" fine_tune: %d\n", fine_tune);
   printf(" overheads: %d\n", measure_overheads);
+  printf("      perf: %d\n", perf_counters);
+  printf("  requests: %d\n", dump_requests);
+  printf("controller: %g (period %lu ms)\n", ctl_target, ctl_period_ms);
+  printf("   elastic: %d (park-idle %lu us, unpark-th %g)\n", elastic_min, park_idle_us, unpark_th);
   printf("dismiss p.: %lu us\n", dismiss_point_us);
+  printf("    pacing: %s\n", rtq_pace_mode_str(pace_mode));
+  printf("      pool: %d\n", pool_size);
+  printf("     mlock: %d (hugepages %d)\n", mem_lock, mem_huge);
+  printf("     abort: %s\n", abort_mode == ABORT_DEADLINE ? "deadline" : abort_mode == ABORT_DISMISS ? "dismiss" : "-");
   printf("      seed: %lu\n", seed);
-  printf("  dlparams: %s\n", dl_params_str());
+  printf("  dlparams: %s\n", virtual_time ? "virtual" : dl_params_str());
+  printf("     stats: %s\n", stats_path ? stats_path : "-");
+  printf("       shm: %s\n", shm_name ? shm_name : "-");
+  printf("     trace: %s\n", trace_path ? trace_path : "-");
+  for (int i = 0; i < workload.n; i++)
+    printf("  workload: stream %d %s period %ld us deadline %ld us jobs %ld\n", i, workload.s[i].path,
+           workload.s[i].period_us, workload.s[i].deadline_us, workload.s[i].num_jobs);
 
   check((dl_runtime_us > 0 && dl_runtime_us < dl_period_us)
          || (dl_runtime_us == 0 && dl_period_us == 0));
@@ -590,88 +1838,288 @@ int main(int argc, char *argv[]) {
 
   check(prob_dismiss_wcet_us == 0 || prob_dismiss_wcet_us >= comp_time_perc_us);
 
-  rtq_init(&q);
-  pd_init(seed);
+  check(elastic_min <= num_child, "--elastic min_threads must not exceed --threads\n");
+  check(!mem_huge || mem_lock, "--hugepages needs --mlock\n");
+  num_active = num_child;
+
+  check(!virtual_time || (shm_name == NULL && ctl_target == 0 && elastic_min == 0 && trace_path == NULL && !perf_counters),
+        "--virtual does not support --shm, --controller, --elastic, --trace nor --perf\n");
+
+  check(pool_size > 0 || num_reqs < MAX_NUM_REQS, "More than 1M jobs need --pool\n");
+  check(pool_size == 0 || pool_size > MAX_SIZE + num_child,
+        "--pool needs more slots than the queue size plus the threads\n");
+  check(pool_size == 0 || (!virtual_time && !measure_overheads), "--pool does not support --virtual nor -o\n");
+  if (pool_size > 0) {
+    pool_jobs = calloc(pool_size, sizeof(job_t));
+    pool_cache = malloc(pool_size * sizeof(job_t *));
+    check(pool_jobs != NULL && pool_cache != NULL, "malloc() failed!");
+    for (pool_cached = 0; pool_cached < pool_size; pool_cached++)
+      pool_cache[pool_cached] = &pool_jobs[pool_size - 1 - pool_cached];
+    for (int i = 0; i <= num_child; i++)
+      job_ring_init(&done_rings[i], pool_size);
+    job_ring_init(&free_ring, pool_size);
+  }
 
-  if (measure_overheads)
-    for (int i = 0; i < MAX_NUM_CHILD; i++)
-      pop_elapsed_num[i] = 0;
+  check(abort_mode != ABORT_DISMISS || dismiss_point_us > 0, "--abort dismiss needs --dismiss-point\n");
+  if (abort_mode != ABORT_NONE && !virtual_time) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = abort_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    check(sigaction(ABORT_SIGNAL, &sa, NULL) == 0, "sigaction() failed!");
+  }
 
-  // parent pinned on affinity_cpu, workers on following ones
-  if (affinity_cpu != -1)
-    set_affinity(affinity_cpu);
+  rtq_init(&q);
+  pd_init(seed);
 
-  pthread_barrier_init(&barrier, NULL, num_child + 1);
+  knobs_t k0 = { push_drop_size, red_min_th, red_max_th, red_max_p,
+                 comp_time_perc_us, prob_dismiss_wcet_us };
+  knobs_publish(&k0);
 
-  for (int i = 0; i < num_child; i++) {
-    pthread_create(&child[i].pthr, NULL, &worker, &child[i]);
+  if (trace_path != NULL) {
+    rtq_trace_enable();
+    check(rtq_trace_thread("generator", gettid()), "rtq_trace_thread() failed!");
   }
 
-  pthread_barrier_wait(&barrier);
-
-  struct timespec ts_next;
-  clock_gettime(CLOCK_MONOTONIC, &ts_next);
-  for (int j = 0; j < num_reqs; j++) {
-    clock_gettime(CLOCK_MONOTONIC, &jobs[j].sent);
-    jobs[j].C_us = ceil(pd_sample(&pd_comp_time_us));
-    //printf("C_us=%u\n", jobs[j].C_us);
-    jobs[j].deadline_ts = jobs[j].sent;
-    ts_add_us(&jobs[j].deadline_ts, pd_sample(&pd_deadline_us));
-
-    struct timespec ts_beg;
-    if (measure_overheads)
-      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_beg);
+  if (shm_name != NULL) {
+    shm = rtq_shm_create(shm_name);
+    check(shm != NULL, "rtq_shm_create() failed!");
+  }
 
-    if (rtq_push(&q, &jobs[j]))
-      jobs[j].elapsed_us = 0;
-    else
-      jobs[j].elapsed_us = -1;
+  if (measure_overheads) {
+    push_elapsed_ns = calloc(num_reqs, sizeof(push_elapsed_ns[0]));
+    check(push_elapsed_ns != NULL, "malloc() failed!");
+    for (int i = 0; i < num_child; i++) {
+      pop_elapsed_ns[i] = calloc(num_reqs, sizeof(pop_elapsed_ns[i][0]));
+      check(pop_elapsed_ns[i] != NULL, "malloc() failed!");
+      wperf[i].pop_elapsed_num = 0;
+    }
+  }
 
+  /* --mlock: lock the address space, then fault in now whatever the run
+     touches: the job slots, the overhead samples of the threads in use,
+     the rings and the shared state (worker stacks: in each thread) */
+  if (mem_lock) {
+    if (rtq_mem_lock() != 0)
+      perror("warning: mlockall() failed");
+    rtq_mem_arena_t arenas[MAX_NUM_CHILD + 16];
+    int n = 0;
+    if (pool_size > 0) {
+      arenas[n++] = (rtq_mem_arena_t){ pool_jobs, pool_size * sizeof(job_t) };
+      arenas[n++] = (rtq_mem_arena_t){ pool_cache, pool_size * sizeof(job_t *) };
+      for (int i = 0; i <= num_child; i++)
+        arenas[n++] = (rtq_mem_arena_t){ done_rings[i].slots, (done_rings[i].mask + 1) * sizeof(job_t *) };
+      arenas[n++] = (rtq_mem_arena_t){ free_ring.slots, (free_ring.mask + 1) * sizeof(job_t *) };
+    } else {
+      arenas[n++] = (rtq_mem_arena_t){ jobs, num_reqs * sizeof(job_t) };
+    }
     if (measure_overheads) {
-      struct timespec ts_end;
-      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_end);
-      push_elapsed_ns[j] = (ts_end.tv_sec - ts_beg.tv_sec) * 1000000000l + (ts_end.tv_nsec - ts_beg.tv_nsec);
+      arenas[n++] = (rtq_mem_arena_t){ push_elapsed_ns, num_reqs * sizeof(push_elapsed_ns[0]) };
+      for (int i = 0; i < num_child; i++)
+        arenas[n++] = (rtq_mem_arena_t){ pop_elapsed_ns[i], num_reqs * sizeof(pop_elapsed_ns[i][0]) };
     }
-
-    if (j == 0 || (j-1) * 10 / num_reqs < j * 10 / num_reqs) {
-      fprintf(stderr, "%d%%...", j*100/num_reqs);
-      fflush(stderr);
+    arenas[n++] = (rtq_mem_arena_t){ &q, sizeof(q) };
+    arenas[n++] = (rtq_mem_arena_t){ wstats, sizeof(wstats) };
+    arenas[n++] = (rtq_mem_arena_t){ wperf, sizeof(wperf) };
+    arenas[n++] = (rtq_mem_arena_t){ park, sizeof(park) };
+    arenas[n++] = (rtq_mem_arena_t){ &pace, sizeof(pace) };
+
+    size_t tot = 0;
+    int failed = 0;
+    for (int i = 0; i < n; i++) {
+      if (mem_huge && arenas[i].len >= RTQ_MEM_HUGE_PAGE && rtq_mem_huge(arenas[i].p, arenas[i].len) != 0)
+        perror("warning: madvise(MADV_HUGEPAGE) failed");
+      failed += rtq_mem_prefault(arenas[i].p, arenas[i].len) != 0;
+      tot += arenas[i].len;
     }
-    ts_add_us(&ts_next, pd_sample(&pd_period_us));
-    check(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts_next, NULL) == 0);
+    rtq_mem_prefault_stack();
+    printf("mlock: prefaulted %.1f MiB in %d arenas, %d not locked\n", tot / 1048576.0, n, failed);
   }
-  fprintf(stderr, "\n");
 
-  printf("Waiting for empty queue...\n");
-  rtq_wait_until_empty(&q);
+  // parent pinned on affinity_cpu, workers on following ones
+  if (affinity_cpu != -1)
+    set_affinity(affinity_cpu);
 
-  printf("Terminating and joining workers...\n");
+  struct timespec ts_run_beg, ts_run_end;
+  if (virtual_time)
+    run_virtual(&ts_run_beg, &ts_run_end);
+  else
+    run_live(&ts_run_beg, &ts_run_end);
 
-  exiting = 1;
+  rtq_cleanup(&q);
 
-  // cause exit of worker threads as they pop &dummy out of q
-  for (int i = 0; i < num_child; i++)
-    // repeat in case push doesn't succeed (full queue or dismissed job)
-    while (!rtq_push(&q, &dummy))
-      usleep(1000);
+  if (!virtual_time)
+    dl_params_cleanup();
+
+  if (trace_path != NULL) {
+    long n = rtq_trace_dump(trace_path);
+    if (n >= 0)
+      printf("trace: %ld events written to %s\n", n, trace_path);
+  }
+
+  if (shm != NULL) {
+    rtq_shm_detach(shm);
+    shm_unlink(shm_name);
+  }
+
+  /* response-time statistics of completed jobs (elapsed_us > 0), same
+     schema as scripts/calcula_stats.sh plus percentiles */
+  RunningStats rt_stats;
+  stats_init(&rt_stats);
+
+  long rejected = 0;
+  if (pool_size > 0) {
+    // already streamed out by the collector
+    rt_stats = pool_rt_stats;
+    rejected = pool_rejected;
+    printf("pool: %d slots, %ld allocations waited for a free one\n", pool_size, pool_stalls);
+  }
+  for (long j = 0; j < num_reqs && pool_size == 0; j++) {
+    if (dump_requests)
+      printf("request %ld sent_us %lu C_us %u elapsed_us %d\n", j, ts_to_us(jobs[j].sent) - ref_sent_us, jobs[j].C_us, (int)jobs[j].elapsed_us);
+    if (jobs[j].elapsed_us > 0)
+      stats_add(&rt_stats, jobs[j].elapsed_us);
+    rejected += jobs[j].elapsed_us < 0;
+    if (jobs[j].stream >= 0)
+      rtq_workload_account(&workload, jobs[j].stream, jobs[j].elapsed_us);
+  }
 
+  /* outcome summary, from the per-worker histograms */
+  worker_stats_t tot;
+  memset(&tot, 0, sizeof(tot));
   for (int i = 0; i < num_child; i++) {
-    pthread_join(child[i].pthr, NULL);
+    hist_merge(&tot.elapsed, &wstats[i].elapsed);
+    hist_merge(&tot.queue, &wstats[i].queue);
+    hist_merge(&tot.slack, &wstats[i].slack);
+    hist_merge(&tot.spinup, &wstats[i].spinup);
+    hist_merge(&tot.abort_lat, &wstats[i].abort_lat);
+    tot.aborted += wstats[i].aborted;
+    tot.aborted_us += wstats[i].aborted_us;
+    tot.parks += wstats[i].parks;
+    tot.active_us += wstats[i].active_us;
+    tot.cpu_us += wstats[i].cpu_us;
+    tot.done += wstats[i].done;
+    tot.dismissed += wstats[i].dismissed;
+    tot.late += wstats[i].late;
+    tot.missed += wstats[i].missed;
+  }
+  printf("summary: jobs %ld accepted %ld rejected %ld done %ld dismissed %ld late %ld missed %ld miss-ratio %.6f\n",
+         num_reqs, num_reqs - rejected, rejected, tot.done, tot.dismissed, tot.late, tot.missed,
+         tot.done > 0 ? tot.missed / (double)tot.done : 0.0);
+  if (abort_mode != ABORT_NONE)
+    printf("summary: aborted %ld aborted_cpu_ms %.1f\n", tot.aborted, tot.aborted_us / 1000.0);
+  struct { const char *name; LogHist *h; } hists[] = {
+    { "elapsed_us", &tot.elapsed }, { "queue_us", &tot.queue }, { "slack_us", &tot.slack },
+    { "spinup_us", &tot.spinup }, { "abort_lat_us", &tot.abort_lat }
+  };
+  for (int k = 0; k < 5; k++) {
+    if ((k == 3 && elastic_min == 0) || (k == 4 && abort_mode == ABORT_NONE))
+      continue;
+    printf("summary: %-10s n %ld mean %.1f p50 %.0f p90 %.0f p99 %.0f p99.9 %.0f max %ld\n",
+           hists[k].name, hists[k].h->n, hist_mean(hists[k].h), hist_quantile(hists[k].h, 0.50),
+           hist_quantile(hists[k].h, 0.90), hist_quantile(hists[k].h, 0.99),
+           hist_quantile(hists[k].h, 0.999), hists[k].h->max);
   }
 
-  rtq_cleanup(&q);
+  /* page faults taken by the generator and the workers during the run */
+  if (!virtual_time) {
+    long minflt = gen_minflt, majflt = gen_majflt;
+    for (int i = 0; i < num_child; i++) {
+      minflt += wstats[i].minflt;
+      majflt += wstats[i].majflt;
+    }
+    printf("summary: faults minor %ld major %ld generator %ld workers %ld\n", minflt, majflt,
+           gen_minflt + gen_majflt, minflt + majflt - gen_minflt - gen_majflt);
+    if (mem_lock && minflt + majflt > 0)
+      fprintf(stderr, "warning: %ld page faults during the measured run despite --mlock\n", minflt + majflt);
+  }
 
-  dl_params_cleanup();
+  /* per-stream outcome of a --workload run */
+  for (int i = 0; i < workload.n; i++) {
+    rtq_stream_t *st = &workload.s[i];
+    printf("summary: stream %d sent %ld rejected %ld done %ld missed %ld miss-ratio %.6f elapsed_us mean %.1f p50 %.0f p99 %.0f max %ld\n",
+           i, st->sent, st->rejected, st->done, st->missed, st->done > 0 ? st->missed / (double)st->done : 0.0,
+           hist_mean(&st->elapsed), hist_quantile(&st->elapsed, 0.50), hist_quantile(&st->elapsed, 0.99),
+           st->elapsed.max);
+  }
+  rtq_workload_close(&workload);
+
+  /* CBS budget: reserved while unparked (runtime/period of the active
+     time) vs. consumed (thread CPU time), and what a fixed pool reserves */
+  double dl_bw = dl_runtime_us > 0 ? dl_runtime_us / (double)dl_period_us : 0.0;
+  long run_us = ts_sub_ns(&ts_run_end, &ts_run_beg) / 1000;
+  if (elastic_min > 0)
+    for (int i = 0; i < num_child; i++)
+      printf("pool: thread %d parks %ld active_ms %.1f reserved_ms %.1f used_ms %.1f\n",
+             i, wstats[i].parks, wstats[i].active_us / 1000.0,
+             wstats[i].active_us * dl_bw / 1000.0, wstats[i].cpu_us / 1000.0);
+  printf("summary: budget run_ms %.1f parks %ld active_ms %.1f reserved_ms %.1f used_ms %.1f fixed-pool_reserved_ms %.1f\n",
+         run_us / 1000.0, tot.parks, tot.active_us / 1000.0, tot.active_us * dl_bw / 1000.0,
+         tot.cpu_us / 1000.0, num_child * run_us * dl_bw / 1000.0);
+
+  /* release jitter of the generator (not with --shm nor --virtual) */
+  if (pace.jitter_ns.n > 0) {
+    printf("summary: pacing %s sleeps %ld overruns %ld", rtq_pace_mode_str(pace.mode),
+           pace.sleeps, pace.overruns);
+    // the margin only applies to (and only adapts in) hybrid mode
+    if (pace.mode == RTQ_PACE_HYBRID)
+      printf(" margin_ns %ld", pace.margin_ns);
+    printf("\n");
+    struct { const char *name; LogHist *h; } phists[] = {
+      { "jitter_ns", &pace.jitter_ns }, { "wakeup_ns", &pace.wakeup_ns }
+    };
+    for (int k = 0; k < 2; k++)
+      printf("summary: %-10s n %ld mean %.1f p50 %.0f p90 %.0f p99 %.0f p99.9 %.0f max %ld\n",
+             phists[k].name, phists[k].h->n, hist_mean(phists[k].h), hist_quantile(phists[k].h, 0.50),
+             hist_quantile(phists[k].h, 0.90), hist_quantile(phists[k].h, 0.99),
+             hist_quantile(phists[k].h, 0.999), phists[k].h->max);
+  }
 
-  long ref_us = ts_to_us(jobs[0].sent);
-  for (int j = 0; j < num_reqs; j++)
-    printf("request %d sent_us %lu C_us %u elapsed_us %d\n", j, ts_to_us(jobs[j].sent) - ref_us, jobs[j].C_us, (int)jobs[j].elapsed_us);
+  stats_write_header(stdout);
+  stats_write_row(stdout, "RTQ", &rt_stats);
+  if (stats_path != NULL) {
+    FILE *f = fopen(stats_path, "w");
+    if (f == NULL) {
+      perror("fopen() of stats file failed");
+    } else {
+      stats_write_header(f);
+      stats_write_row(f, "RTQ", &rt_stats);
+      fclose(f);
+    }
+  }
 
   if (measure_overheads) {
-    for (int j = 0; j < num_reqs; j++)
-      printf("overheads: request %d push_elapsed_ns: %lu\n", j, push_elapsed_ns[j]);
+    for (long j = 0; j < num_reqs; j++)
+      printf("overheads: request %ld push_elapsed_ns: %lu\n", j, push_elapsed_ns[j]);
     for (int i = 0; i < num_child; i++)
-      for (int j = 0; j < pop_elapsed_num[i]; j++)
+      for (long j = 0; j < wperf[i].pop_elapsed_num; j++)
         printf("overheads: thread %d pop_elapsed_ns: %lu\n", i, pop_elapsed_ns[i][j]);
   }
+
+  if (perf_counters) {
+    static const char *phases[3] = { "pop", "wait", "job" };
+    rtq_perf_acc_t tot[3];
+    memset(tot, 0, sizeof(tot));
+    for (int i = 0; i < num_child; i++) {
+      for (int ph = 0; ph < 3; ph++) {
+        rtq_perf_acc_t *a = ph == 0 ? &wperf[i].pop : ph == 1 ? &wperf[i].wait : &wperf[i].job;
+        printf("perf: thread %d (%s) phase %s n %lu", i, rtq_perf_mode_str(wperf[i].mode),
+               phases[ph], a->n);
+        tot[ph].n += a->n;
+        for (int k = 0; k < RTQ_PERF_NUM; k++) {
+          printf(" %s %lu", rtq_perf_name(k), a->v[k]);
+          tot[ph].v[k] += a->v[k];
+        }
+        printf("\n");
+      }
+    }
+    for (int ph = 0; ph < 3; ph++) {
+      printf("perf: per-%s average:", phases[ph]);
+      for (int k = 0; k < RTQ_PERF_NUM; k++)
+        printf(" %s %.2f", rtq_perf_name(k), tot[ph].n ? tot[ph].v[k] / (double)tot[ph].n : 0.0);
+      printf("\n");
+    }
+  }
 }
+#endif
@@ -10,7 +10,7 @@ rm -f graficos/*.png
 
 echo "[2] Compilando..."
 
-gcc -O2 -Wall -o sim sim.c -lm
+gcc -O2 -Wall -pthread -o sim sim.c stats.c src/trace.c -lm
 
 
 echo "[3] Executando simulação..."
@@ -1,4 +1,6 @@
 #!/bin/bash
+# Obs.: o sim já grava logs/stats.csv (com percentis) durante a execução;
+# este script fica apenas para reprocessar logs antigos.
 
 input="logs/log_runs.csv"
 output="logs/stats.csv"
@@ -1,2 +1,2 @@
-gcc -O2 -Wall -o red_vs_jams red_vs_jams.c -lm
+gcc -O2 -Wall -o red_vs_jams red_vs_jams.c trace.c -lm
 
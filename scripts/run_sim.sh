@@ -7,7 +7,7 @@ rm -f graficos/*.png
 
 echo "[2] Executando simulação..."
 
-gcc -O2 -Wall -o sim sim.c -lm
+gcc -O2 -Wall -pthread -o sim sim.c stats.c src/trace.c -lm
 
 ./sim traces/MPC_times/MPC_long_10/saved_times_long_0.csv > /dev/null 2>&1
 
@@ -2,7 +2,16 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <stdint.h>
 #include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+
+#include "stats.h"
+#include "src/trace.h"
 
 #ifndef DEFAULT_NUM_RUNS
 #define DEFAULT_NUM_RUNS 100
@@ -20,6 +29,63 @@
 #define OVERHEAD_JAMS 1.1
 #endif
 
+#ifndef MAX_SWEEP_THREADS
+#define MAX_SWEEP_THREADS 64
+#endif
+
+#ifndef MAX_STREAMS
+#define MAX_STREAMS 16
+#endif
+
+/*
+ * Gerador baseado em contador (Philox4x32-10, Salmon et al., SC'11).
+ *
+ * Cada sorteio é uma função pura de (seed, stream, tipo, rodada, tarefa), sem
+ * estado compartilhado: qualquer sorteio pode ser calculado isoladamente, os
+ * resultados não dependem do número de threads nem da ordem de execução, e
+ * uma rodada pode ser reproduzida sozinha (--run).
+ */
+typedef struct {
+    uint64_t seed;
+    uint32_t stream;   // separa traces independentes (modo lote)
+} Rng;
+
+enum {
+    RNG_VALUE = 0,     // Task.value, por tarefa
+    RNG_JAMS = 1       // aceitação probabilística do JAMS, por (rodada, tarefa)
+};
+
+static inline uint32_t mulhilo32(uint32_t a, uint32_t b, uint32_t *hi) {
+    uint64_t p = (uint64_t)a * b;
+    *hi = (uint32_t)(p >> 32);
+    return (uint32_t)p;
+}
+
+void philox4x32_10(uint32_t ctr[4], const uint32_t key[2]) {
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+        uint32_t hi0, hi1;
+        uint32_t lo0 = mulhilo32(0xD2511F53u, ctr[0], &hi0);
+        uint32_t lo1 = mulhilo32(0xCD9E8D57u, ctr[2], &hi1);
+        uint32_t c1 = ctr[1], c3 = ctr[3];
+        ctr[0] = hi1 ^ c1 ^ k0;
+        ctr[1] = lo1;
+        ctr[2] = hi0 ^ c3 ^ k1;
+        ctr[3] = lo0;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+}
+
+/* Uniforme em [0, 1) com 53 bits, para o sorteio (tipo, rodada, tarefa) */
+double rng_uniform(const Rng *g, uint32_t kind, uint32_t run, uint32_t task) {
+    uint32_t ctr[4] = { task, run, kind, g->stream };
+    const uint32_t key[2] = { (uint32_t)g->seed, (uint32_t)(g->seed >> 32) };
+    philox4x32_10(ctr, key);
+    uint64_t bits = ((uint64_t)ctr[0] << 32 | ctr[1]) >> 11;
+    return bits * (1.0 / 9007199254740992.0);
+}
+
 typedef struct {
     int id;
     double computation_ms; // usando double para precisão
@@ -34,31 +100,84 @@ typedef struct {
     int jams_accepted;
 } Result;
 
-/**
- * Lê o CSV e preenche o vetor tasks.
- * Espera o CSV com pelo menos 1 coluna (tempo C em segundos).
- * Se houver mais colunas, apenas a primeira é usada.
- *
- * Retorna o número de tarefas carregadas (0 se erro).
+/*
+ * Leitor incremental do trace: devolve uma tarefa por chamada, sem manter o
+ * trace em memória. Usado tanto para carregar a tabela inteira quanto pelo
+ * modo --stream, que processa o trace em blocos. Aceita CSV ou o formato
+ * binário .rtb (src/trace.h, gerado por src/trace_conv), lido via mmap.
  */
-int load_tasks_from_csv(const char *filename, Task **out_tasks) {
-    FILE *f = fopen(filename, "r");
-    if (!f) {
+typedef struct {
+    FILE *f;
+    int binary;
+    rtb_trace_t rtb;
+    rtb_iter_t it;
+    int count;         // tarefas lidas até agora
+    const Rng *rng;
+} TaskReader;
+
+int task_reader_open(TaskReader *r, const char *filename, const Rng *rng) {
+    r->count = 0;
+    r->rng = rng;
+    r->binary = rtb_is_binary(filename);
+    if (r->binary) {
+        if (!rtb_open(&r->rtb, filename))
+            return 0;
+        rtb_iter_init(&r->it, &r->rtb);
+        return 1;
+    }
+
+    r->f = fopen(filename, "r");
+    if (!r->f) {
         fprintf(stderr, "Erro ao abrir %s\n", filename);
         return 0;
     }
+    return 1;
+}
 
-    char line[1024];
-    int capacity = 1024; // capacidade inicial
-    int count = 0;
-    Task *tasks = malloc(sizeof(Task) * capacity);
-    if (!tasks) {
-        fclose(f);
-        fprintf(stderr, "Erro de alocacao\n");
-        return 0;
+void task_reader_close(TaskReader *r) {
+    if (r->binary)
+        rtb_close(&r->rtb);
+    else
+        fclose(r->f);
+}
+
+/* Próxima tarefa do trace binário: tempos em ticks de tick_ns */
+int task_reader_next_binary(TaskReader *r, Task *t) {
+    job_t j;
+    double ms_per_tick = r->rtb.hdr->tick_ns / 1e6;
+
+    while (rtb_next(&r->it, &j)) {
+        if (j.exec_time == 0) continue;
+
+        t->id = r->count + 1;
+        t->computation_ms = j.exec_time * ms_per_tick;
+        t->deadline_ms = j.abs_deadline > j.release_time
+            ? (j.abs_deadline - j.release_time) * ms_per_tick : -1.0;
+        t->value = (int)(rng_uniform(r->rng, RNG_VALUE, 0, r->count) * 100);
+
+        r->count++;
+        return 1;
     }
+    return 0;
+}
+
+/**
+ * Lê a próxima tarefa do CSV.
+ * Linhas "índice,segundos" (formato dos MPC_times, o mesmo lido por
+ * src/trace_conv e pelo --workload do rtqueue) dão o tempo C em segundos na
+ * segunda coluna. Nos demais formatos vale a primeira coluna, em µs; as
+ * outras colunas são ignoradas.
+ * O value de cada tarefa é sorteado por rng (tipo RNG_VALUE, índice da tarefa).
+ *
+ * Retorna 1 se leu uma tarefa, 0 no fim do arquivo.
+ */
+int task_reader_next(TaskReader *r, Task *t) {
+    char line[1024];
 
-    while (fgets(line, sizeof(line), f)) {
+    if (r->binary)
+        return task_reader_next_binary(r, t);
+
+    while (fgets(line, sizeof(line), r->f)) {
         // Trim leading spaces
         char *p = line;
         while (*p == ' ' || *p == '\t') p++;
@@ -68,31 +187,74 @@ int load_tasks_from_csv(const char *filename, Task **out_tasks) {
         if (strncasecmp(p, "timestamp", 9) == 0) continue;
         if (p[0] == '#') continue; // comentário
 
-        // pegar a primeira token - tempo em segundos
-        char *token = strtok(p, ",;\t\n\r");
+        // MPC_times: exatamente duas colunas, índice inteiro e segundos
+        long index;
+        double seconds;
+        int consumed = 0;
+        if (sscanf(p, "%ld,%lf%n", &index, &seconds, &consumed) == 2 && index >= 0
+            && strchr(p + consumed, ',') == NULL) {
+            if (seconds <= 0.0) continue;
+            t->id = r->count + 1;
+            t->computation_ms = seconds * 1000.0;
+            t->deadline_ms = -1.0;
+            t->value = (int)(rng_uniform(r->rng, RNG_VALUE, 0, r->count) * 100);
+            r->count++;
+            return 1;
+        }
+
+        // pegar a primeira token - tempo em µs
+        char *save;
+        char *token = strtok_r(p, ",;\t\n\r", &save);
         if (!token) continue;
 
         double C_seconds = atof(token);
         if (C_seconds <= 0.0) continue;
 
+        t->id = r->count + 1;
+        // t->computation_ms = C_seconds * 1000.0; // converter para ms
+        t->computation_ms = C_seconds / 1000.0;  // µs → ms
+
+        t->deadline_ms = -1.0; // ainda indefinido (vai ser setado depois)
+        t->value = (int)(rng_uniform(r->rng, RNG_VALUE, 0, r->count) * 100);
+
+        r->count++;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Lê o CSV inteiro e preenche o vetor tasks.
+ *
+ * Retorna o número de tarefas carregadas (0 se erro).
+ */
+int load_tasks_from_csv(const char *filename, Task **out_tasks, const Rng *rng) {
+    TaskReader r;
+    if (!task_reader_open(&r, filename, rng))
+        return 0;
+
+    int capacity = 1024; // capacidade inicial
+    int count = 0;
+    Task *tasks = malloc(sizeof(Task) * capacity);
+    if (!tasks) {
+        task_reader_close(&r);
+        fprintf(stderr, "Erro de alocacao\n");
+        return 0;
+    }
+
+    while (1) {
         if (count >= capacity) {
             capacity *= 2;
             Task *tmp = realloc(tasks, sizeof(Task) * capacity);
-            if (!tmp) { free(tasks); fclose(f); fprintf(stderr, "Erro realloc\n"); return 0; }
+            if (!tmp) { free(tasks); task_reader_close(&r); fprintf(stderr, "Erro realloc\n"); return 0; }
             tasks = tmp;
         }
-
-        tasks[count].id = count + 1;
-        // tasks[count].computation_ms = C_seconds * 1000.0; // converter para ms
-        tasks[count].computation_ms = C_seconds / 1000.0;  // µs → ms
-
-        tasks[count].deadline_ms = -1.0; // ainda indefinido (vai ser setado depois)
-        tasks[count].value = rand() % 100;
-
+        if (!task_reader_next(&r, &tasks[count]))
+            break;
         count++;
     }
 
-    fclose(f);
+    task_reader_close(&r);
 
     // compactar
     *out_tasks = tasks;
@@ -113,75 +275,63 @@ void assign_deadlines(Task tasks[], int n, double default_deadline_ms) {
     }
 }
 
-/**
- * RED real baseado em EDF: aceita se soma(C_i / D_i) <= 1
- *
- * Retorna Result preenchido (tempo de resposta aproximado e contagem aceitas).
- * Modelo simples de tempo de resposta: R ~= C * (1 + U) onde U é utilizacao após aceitar.
+/*
+ * Estado de uma rodada, avançado tarefa a tarefa. As versões com log, a
+ * varredura e o modo --stream usam os mesmos passos, então produzem os mesmos
+ * resultados.
  */
-Result simulate_RED(Task tasks[], int n) {
-    Result res = {0.0, 0.0, 0, 0};
-    double utilization = 0.0;
-    double total_rt = 0.0;
+typedef struct {
+    double utilization;
+    double total_rt;
+    int accepted;
+} RedState;
 
-    for (int i = 0; i < n; ++i) {
-        double C = tasks[i].computation_ms;
-        double D = tasks[i].deadline_ms;
-        if (D <= 0.0) continue; // segurança
-
-        double new_util = utilization + (C / D);
-        if (new_util <= 1.0 + 1e-12) {
-            // aceita
-            utilization = new_util;
-            res.red_accepted++;
-            double response_time = C * (1.0 + utilization); // modelo aproximado
-            total_rt += response_time;
-        } else {
-            // rejeita
-        }
+typedef struct {
+    double current_load;
+    double total_rt;
+    int accepted;
+} JamsState;
+
+/* Um passo do RED (teste de utilização); devolve 1 se aceitou e o rt em *rt */
+static inline int red_step(RedState *st, const Task *t, double *rt) {
+    double new_util = st->utilization + (t->computation_ms / t->deadline_ms);
+
+    *rt = 0.0;
+    if (new_util <= 1.0) {
+        st->utilization = new_util;
+        st->accepted++;
+        *rt = t->computation_ms * (1.0 + st->utilization);
+        st->total_rt += *rt;
+        return 1;
     }
-
-    if (res.red_accepted > 0) res.red_response_time = total_rt / res.red_accepted;
-    return res;
+    return 0;
 }
 
-/**
- * JAMS: tentativa determinística, se falhar tenta probabilística com base no value e overload.
- * current_load e MAX_CAPACITY são interpretados em ms.
- * Overhead é aplicado ao tempo de resposta.
- */
-Result simulate_JAMS(Task tasks[], int n, double MAX_CAPACITY_MS) {
-    Result res = {0.0, 0.0, 0, 0};
-    double current_load = 0.0;
-    double total_rt = 0.0;
+/* Um passo do JAMS para a tarefa de índice task (0-based) na rodada run */
+static inline int jams_step(JamsState *st, const Task *t, int task, double MAX_CAPACITY_MS,
+                            const Rng *rng, int run, double *rt) {
+    double C = t->computation_ms;
+    int accepted = 0;
 
-    for (int i = 0; i < n; ++i) {
-        int accepted = 0;
-        double C = tasks[i].computation_ms;
-        if (current_load + C <= MAX_CAPACITY_MS + 1e-9) {
-            accepted = 1;
-        } else {
-            double overload = (current_load + C) - MAX_CAPACITY_MS;
-            if (overload < 0.0) overload = 0.0;
-            // fórmula de probabilidade estabilizada:
-            // maiores value => maior chance; maior overload => menor chance
-            double val = (double)tasks[i].value;
-            double prob = val / (val + overload * 10.0 + 1.0);
-            if (prob < 0.0) prob = 0.0;
-            if (prob > 1.0) prob = 1.0;
-            double r = (double)rand() / (RAND_MAX + 1.0);
-            if (r < prob) accepted = 1;
-        }
+    if (st->current_load + C <= MAX_CAPACITY_MS) {
+        accepted = 1;
+    } else {
+        double overload = (st->current_load + C) - MAX_CAPACITY_MS;
+        double val = t->value;
+        double prob = val / (val + overload * 10.0 + 1.0);
 
-        if (accepted) {
-            current_load += C;
-            res.jams_accepted++;
-            total_rt += current_load * OVERHEAD_JAMS;
-        }
+        double r = rng_uniform(rng, RNG_JAMS, run, task);
+        if (r < prob) accepted = 1;
     }
 
-    if (res.jams_accepted > 0) res.jams_response_time = total_rt / res.jams_accepted;
-    return res;
+    *rt = 0.0;
+    if (accepted) {
+        st->current_load += C;
+        *rt = st->current_load * OVERHEAD_JAMS;
+        st->accepted++;
+        st->total_rt += *rt;
+    }
+    return accepted;
 }
 
 void print_ascii_bar(const char* label, double value, int max_scale) {
@@ -193,139 +343,824 @@ void print_ascii_bar(const char* label, double value, int max_scale) {
 }
 
 void usage(const char *prog) {
-    printf("Uso: %s <csv_path> [num_runs] [deadline_ms] [max_capacity_ms]\n", prog);
+    printf("Uso: %s [opcoes] <csv_path> [num_runs] [deadline_ms] [max_capacity_ms]\n", prog);
     printf("Exemplo: %s MPC_times/MPC_long_10/saved_times_long_0.csv 100 80 50\n", prog);
+    printf("Opcoes:\n");
+    printf("  --sweep dl_ini:dl_fim:passo cap_ini:cap_fim:passo  varre a grade deadline x capacidade\n");
+    printf("  -t|--threads n                                     threads da varredura/lote (padrao: nucleos online)\n");
+    printf("  -s|--seed n                                        semente (padrao: time ^ pid; impressa na saida)\n");
+    printf("  --run k                                            reproduz apenas a rodada k (0-based)\n");
+    printf("  --stream chunk                                     le o trace em blocos, memoria constante (sem log_tasks.csv)\n");
+    printf("  --workload trace:periodo_ms:deadline_ms            uma stream da carga mista (repetivel); substitui csv_path:\n");
+    printf("                                                     %s --workload A:100:200 --workload B:40:80 [num_runs] [max_capacity_ms]\n", prog);
+    printf("Se csv_path for um diretorio ou um glob (entre aspas), processa todos os traces em lote.\n");
 }
 
+/* Intervalo "inicio:fim:passo" (ou um valor unico) para o modo --sweep */
+typedef struct {
+    double start;
+    double end;
+    double step;
+} Range;
+
+int parse_range(const char *s, Range *r) {
+    int n = sscanf(s, "%lf:%lf:%lf", &r->start, &r->end, &r->step);
+    if (n == 1) {
+        r->end = r->start;
+        r->step = 1.0;
+    } else if (n != 3) {
+        return 0;
+    }
+    return r->step > 0.0 && r->end >= r->start;
+}
 
-Result simulate_RED_logged(Task tasks[], int n, FILE *log_task) {
-    Result res = {0.0, 0.0, 0, 0};
-    double utilization = 0.0;
-    double total_rt = 0.0;
+int range_count(const Range *r) {
+    return (int)floor((r->end - r->start) / r->step + 1e-9) + 1;
+}
 
-    for (int i = 0; i < n; ++i) {
-        double C = tasks[i].computation_ms;
-        double D = tasks[i].deadline_ms;
+double range_value(const Range *r, int i) {
+    return r->start + i * r->step;
+}
+
+/*
+ * Varredura deadline x capacidade.
+ *
+ * O RED não depende da capacidade e é determinístico, e o JAMS não depende do
+ * deadline: a grade nd x nc se reduz a nd simulações RED e nc x num_runs
+ * simulações JAMS, combinadas no final. Os itens (um por deadline e um por
+ * capacidade) são distribuídos entre as threads por um contador atômico, todas
+ * lendo a mesma tabela de tarefas (somente leitura).
+ */
+typedef struct {
+    const Task *tasks;
+    int n;
+    int first_run;
+    int num_runs;
+    Range deadlines;
+    Range capacities;
+    int nd;
+    int nc;
+    Rng rng;
+    int next_item;   // próximo item a processar (acesso atômico)
+    Result *red;     // [nd] (RED é determinístico: basta 1 rodada)
+    double *jams_acc; // [nc], média de aceitas em num_runs rodadas
+    double *jams_rt;  // [nc], média do tempo de resposta em num_runs rodadas
+} Sweep;
+
+void *sweep_worker(void *arg) {
+    Sweep *sw = (Sweep *)arg;
+    int total = sw->nd + sw->nc;
+    int item;
+
+    while ((item = __atomic_fetch_add(&sw->next_item, 1, __ATOMIC_RELAXED)) < total) {
+        double rt;
+        if (item < sw->nd) {
+            // a tabela é compartilhada: o deadline do ponto vai numa cópia da tarefa
+            double dl = range_value(&sw->deadlines, item);
+            RedState st = {0.0, 0.0, 0};
+            for (int i = 0; i < sw->n; ++i) {
+                Task t = sw->tasks[i];
+                if (t.deadline_ms <= 0.0) t.deadline_ms = dl;
+                red_step(&st, &t, &rt);
+            }
+            Result *r = &sw->red[item];
+            r->red_accepted = st.accepted;
+            if (st.accepted > 0) r->red_response_time = st.total_rt / st.accepted;
+            continue;
+        }
+
+        int c = item - sw->nd;
+        double cap = range_value(&sw->capacities, c);
+        double rt_sum = 0.0;
+        long acc_sum = 0;
+        for (int run = sw->first_run; run < sw->first_run + sw->num_runs; ++run) {
+            // mesmos sorteios por rodada em todas as capacidades (números aleatórios comuns)
+            JamsState st = {0.0, 0.0, 0};
+            for (int i = 0; i < sw->n; ++i)
+                jams_step(&st, &sw->tasks[i], i, cap, &sw->rng, run, &rt);
+            if (st.accepted > 0) rt_sum += st.total_rt / st.accepted;
+            acc_sum += st.accepted;
+        }
+        sw->jams_rt[c] = rt_sum / sw->num_runs;
+        sw->jams_acc[c] = (double)acc_sum / sw->num_runs;
+    }
+    return NULL;
+}
+
+int run_sweep(const Task tasks[], int n, int first_run, int num_runs, const Range *deadlines,
+              const Range *capacities, int num_threads, const Rng *rng) {
+    Sweep sw = {
+        .tasks = tasks, .n = n, .first_run = first_run, .num_runs = num_runs,
+        .deadlines = *deadlines, .capacities = *capacities,
+        .nd = range_count(deadlines), .nc = range_count(capacities),
+        .rng = *rng, .next_item = 0
+    };
+    sw.red = calloc(sw.nd, sizeof(Result));
+    sw.jams_acc = calloc(sw.nc, sizeof(double));
+    sw.jams_rt = calloc(sw.nc, sizeof(double));
+    if (!sw.red || !sw.jams_acc || !sw.jams_rt) {
+        fprintf(stderr, "Erro de alocacao\n");
+        free(sw.red);
+        free(sw.jams_acc);
+        free(sw.jams_rt);
+        return 0;
+    }
+
+    if (num_threads > sw.nd + sw.nc) num_threads = sw.nd + sw.nc;
+    pthread_t thr[MAX_SWEEP_THREADS];
+    for (int i = 1; i < num_threads; ++i)
+        pthread_create(&thr[i], NULL, sweep_worker, &sw);
+    sweep_worker(&sw);
+    for (int i = 1; i < num_threads; ++i)
+        pthread_join(thr[i], NULL);
+
+    FILE *f = fopen("logs/sweep.csv", "w");
+    if (!f) {
+        fprintf(stderr, "Erro ao criar logs/sweep.csv\n");
+        free(sw.red);
+        free(sw.jams_acc);
+        free(sw.jams_rt);
+        return 0;
+    }
+    fprintf(f, "deadline_ms,max_capacity_ms,red_accepted,red_time_ms,jams_accepted,jams_time_ms\n");
+    for (int d = 0; d < sw.nd; ++d)
+        for (int c = 0; c < sw.nc; ++c)
+            fprintf(f, "%.3f,%.3f,%d,%.5f,%.2f,%.5f\n",
+                    range_value(&sw.deadlines, d), range_value(&sw.capacities, c),
+                    sw.red[d].red_accepted, sw.red[d].red_response_time,
+                    sw.jams_acc[c], sw.jams_rt[c]);
+    fclose(f);
+
+    printf("Varredura: %d deadlines x %d capacidades = %d pontos, %d rodadas, %d threads\n",
+           sw.nd, sw.nc, sw.nd * sw.nc, num_runs, num_threads);
+    printf("[INFO] Resultados exportados para 'logs/sweep.csv'\n");
 
-        double load_before = utilization;
-        int accepted = 0;
-        double rt = 0.0;
+    free(sw.red);
+    free(sw.jams_acc);
+    free(sw.jams_rt);
+    return 1;
+}
+
+
+/*
+ * Modo lote: csv_path é um diretório (todos os *.csv) ou um glob.
+ *
+ * Cada trace é uma unidade de trabalho de um pool de threads: a thread carrega
+ * o arquivo e o simula sem logs por tarefa, então a leitura de um trace se
+ * sobrepõe à simulação dos outros. Os resultados de cada trace (médias das
+ * rodadas) são agregados em logs/batch.csv, com média e IC de 95% entre traces.
+ */
+typedef struct {
+    int n;             // tarefas carregadas (0 se erro)
+    double red_acc;
+    double red_rt;
+    double jams_acc;
+    double jams_rt;
+} BatchResult;
+
+typedef struct {
+    char **paths;
+    int num_paths;
+    int first_run;
+    int num_runs;
+    double deadline_ms;
+    double capacity_ms;
+    uint64_t seed;
+    int next_item;     // próximo trace a processar (acesso atômico)
+    BatchResult *res;  // [num_paths]
+} Batch;
+
+int cmp_str(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
 
-        double new_util = utilization + (C / D);
+/*
+ * Expande csv_path em uma lista ordenada de traces. Retorna o número de
+ * arquivos, ou -1 se csv_path não for diretório nem glob (modo normal).
+ */
+int collect_traces(const char *path, char ***out_paths) {
+    struct stat st;
+    int count = 0;
+    char **paths = NULL;
+
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+        DIR *d = opendir(path);
+        if (!d) return 0;
+        int capacity = 0;
+        struct dirent *e;
+        while ((e = readdir(d)) != NULL) {
+            size_t len = strlen(e->d_name);
+            if (len < 4 || strcasecmp(e->d_name + len - 4, ".csv") != 0) continue;
+            if (count >= capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                char **tmp = realloc(paths, sizeof(char *) * capacity);
+                if (!tmp) break;
+                paths = tmp;
+            }
+            size_t sz = strlen(path) + len + 2;
+            paths[count] = malloc(sz);
+            if (!paths[count]) break;
+            snprintf(paths[count], sz, "%s/%s", path, e->d_name);
+            count++;
+        }
+        closedir(d);
+        if (count > 0) qsort(paths, count, sizeof(char *), cmp_str);
+    } else if (strpbrk(path, "*?[")) {
+        glob_t g;
+        if (glob(path, 0, NULL, &g) == 0 && g.gl_pathc > 0) {
+            paths = malloc(sizeof(char *) * g.gl_pathc);
+            for (size_t i = 0; paths && i < g.gl_pathc; ++i)
+                paths[count++] = strdup(g.gl_pathv[i]);
+        }
+        globfree(&g);
+    } else {
+        return -1;
+    }
+
+    *out_paths = paths;
+    return count;
+}
+
+void *batch_worker(void *arg) {
+    Batch *b = (Batch *)arg;
+    int item;
+
+    while ((item = __atomic_fetch_add(&b->next_item, 1, __ATOMIC_RELAXED)) < b->num_paths) {
+        BatchResult *r = &b->res[item];
+        Rng rng = { b->seed, (uint32_t)item };  // traces independentes entre si
+        Task *tasks = NULL;
+        r->n = load_tasks_from_csv(b->paths[item], &tasks, &rng);
+        if (r->n <= 0) {
+            free(tasks);
+            continue;
+        }
+        assign_deadlines(tasks, r->n, b->deadline_ms);
+
+        // RED é determinístico: uma rodada basta
+        double rt;
+        RedState red = {0.0, 0.0, 0};
+        for (int i = 0; i < r->n; ++i)
+            red_step(&red, &tasks[i], &rt);
+        r->red_acc = red.accepted;
+        r->red_rt = red.accepted > 0 ? red.total_rt / red.accepted : 0.0;
+
+        double rt_sum = 0.0;
+        long acc_sum = 0;
+        for (int run = b->first_run; run < b->first_run + b->num_runs; ++run) {
+            JamsState jams = {0.0, 0.0, 0};
+            for (int i = 0; i < r->n; ++i)
+                jams_step(&jams, &tasks[i], i, b->capacity_ms, &rng, run, &rt);
+            if (jams.accepted > 0) rt_sum += jams.total_rt / jams.accepted;
+            acc_sum += jams.accepted;
+        }
+        r->jams_acc = (double)acc_sum / b->num_runs;
+        r->jams_rt = rt_sum / b->num_runs;
+        free(tasks);
+    }
+    return NULL;
+}
+
+int run_batch(char **paths, int num_paths, int first_run, int num_runs, double deadline_ms,
+              double capacity_ms, int num_threads, uint64_t seed) {
+    Batch b = {
+        .paths = paths, .num_paths = num_paths, .first_run = first_run, .num_runs = num_runs,
+        .deadline_ms = deadline_ms, .capacity_ms = capacity_ms,
+        .seed = seed, .next_item = 0
+    };
+    b.res = calloc(num_paths, sizeof(BatchResult));
+    if (!b.res) {
+        fprintf(stderr, "Erro de alocacao\n");
+        return 0;
+    }
+
+    if (num_threads > num_paths) num_threads = num_paths;
+    pthread_t thr[MAX_SWEEP_THREADS];
+    for (int i = 1; i < num_threads; ++i)
+        pthread_create(&thr[i], NULL, batch_worker, &b);
+    batch_worker(&b);
+    for (int i = 1; i < num_threads; ++i)
+        pthread_join(thr[i], NULL);
+
+    FILE *f = fopen("logs/batch.csv", "w");
+    if (!f) {
+        fprintf(stderr, "Erro ao criar logs/batch.csv\n");
+        free(b.res);
+        return 0;
+    }
 
-        if (new_util <= 1.0) {
-            accepted = 1;
-            utilization = new_util;
-            res.red_accepted++;
-            rt = C * (1.0 + utilization);
-            total_rt += rt;
+    // estatísticas entre traces: aceitas e tempo de RED e JAMS
+    RunningStats st[4];
+    for (int k = 0; k < 4; ++k) stats_init(&st[k]);
+
+    fprintf(f, "trace,tasks,red_accepted,red_time_ms,jams_accepted,jams_time_ms\n");
+    int loaded = 0;
+    for (int i = 0; i < num_paths; ++i) {
+        BatchResult *r = &b.res[i];
+        if (r->n <= 0) {
+            fprintf(stderr, "Nenhuma tarefa carregada de %s\n", paths[i]);
+            continue;
         }
+        loaded++;
+        fprintf(f, "%s,%d,%.2f,%.5f,%.2f,%.5f\n",
+                paths[i], r->n, r->red_acc, r->red_rt, r->jams_acc, r->jams_rt);
+        stats_add(&st[0], r->red_acc);
+        stats_add(&st[1], r->red_rt);
+        stats_add(&st[2], r->jams_acc);
+        stats_add(&st[3], r->jams_rt);
+    }
+    fprintf(f, "mean,%d,%.2f,%.5f,%.2f,%.5f\n", loaded,
+            st[0].mean, st[1].mean, st[2].mean, st[3].mean);
+    fprintf(f, "ci95,%d,%.2f,%.5f,%.2f,%.5f\n", loaded,
+            stats_ci95(&st[0]), stats_ci95(&st[1]), stats_ci95(&st[2]), stats_ci95(&st[3]));
+    fclose(f);
+
+    printf("Lote: %d/%d traces, %d rodadas, %d threads\n", loaded, num_paths, num_runs, num_threads);
+    printf("RED : Aceitou %.2f +- %.2f tarefas. Tempo Medio: %.2f +- %.2f ms\n",
+           st[0].mean, stats_ci95(&st[0]), st[1].mean, stats_ci95(&st[1]));
+    printf("JAMS: Aceitou %.2f +- %.2f tarefas. Tempo Medio: %.2f +- %.2f ms\n",
+           st[2].mean, stats_ci95(&st[2]), st[3].mean, stats_ci95(&st[3]));
+    printf("[INFO] Resultados exportados para 'logs/batch.csv'\n");
+
+    free(b.res);
+    return loaded > 0;
+}
+
+Result simulate_RED_logged(Task tasks[], int n, FILE *log_task) {
+    Result res = {0.0, 0.0, 0, 0};
+    RedState st = {0.0, 0.0, 0};
 
-        double load_after = utilization;
+    for (int i = 0; i < n; ++i) {
+        double load_before = st.utilization;
+        double rt;
+        int accepted = red_step(&st, &tasks[i], &rt);
 
         // registrar tarefa
         fprintf(log_task, "%d,RED,%d,%.5f,%.5f,%.5f\n",
-                i + 1, accepted, rt, load_before, load_after);
+                i + 1, accepted, rt, load_before, st.utilization);
     }
 
+    res.red_accepted = st.accepted;
     if (res.red_accepted > 0) {
-        res.red_response_time = total_rt / res.red_accepted;
+        res.red_response_time = st.total_rt / res.red_accepted;
     }
     return res;
 }
 
-Result simulate_JAMS_logged(Task tasks[], int n, double MAX_CAPACITY_MS, FILE *log_task) {
+Result simulate_JAMS_logged(Task tasks[], int n, double MAX_CAPACITY_MS, const Rng *rng, int run, FILE *log_task) {
     Result res = {0.0, 0.0, 0, 0};
-    double current_load = 0.0;
-    double total_rt = 0.0;
+    JamsState st = {0.0, 0.0, 0};
 
     for (int i = 0; i < n; ++i) {
-        double C = tasks[i].computation_ms;
+        double load_before = st.current_load;
+        double rt;
+        int accepted = jams_step(&st, &tasks[i], i, MAX_CAPACITY_MS, rng, run, &rt);
 
-        double load_before = current_load;
-        int accepted = 0;
-        double rt = 0.0;
+        fprintf(log_task, "%d,JAMS,%d,%.5f,%.5f,%.5f\n",
+                i + 1, accepted, rt, load_before, st.current_load);
+    }
 
-        if (current_load + C <= MAX_CAPACITY_MS) {
-            accepted = 1;
-        } else {
-            double overload = (current_load + C) - MAX_CAPACITY_MS;
-            double val = tasks[i].value;
-            double prob = val / (val + overload * 10.0 + 1.0);
+    res.jams_accepted = st.accepted;
+    if (res.jams_accepted > 0) {
+        res.jams_response_time = st.total_rt / res.jams_accepted;
+    }
+    return res;
+}
+
+/*
+ * Modo --stream: lê o trace em blocos de chunk tarefas e avança todas as
+ * rodadas em lockstep sobre cada bloco, com memória limitada a
+ * chunk + num_runs estados, independente do tamanho do trace. Como os
+ * sorteios dependem só de (seed, rodada, tarefa), o resultado é idêntico ao do
+ * modo normal; apenas logs/log_tasks.csv não é gerado.
+ */
+int run_stream(const char *csv_path, int chunk, int first_run, int num_runs,
+               double default_deadline_ms, double max_capacity_ms, const Rng *rng,
+               Result *out, int *out_tasks) {
+    TaskReader reader;
+    if (!task_reader_open(&reader, csv_path, rng))
+        return 0;
+
+    Task *buf = malloc(sizeof(Task) * chunk);
+    JamsState *jams = calloc(num_runs, sizeof(JamsState));
+    if (!buf || !jams) {
+        fprintf(stderr, "Erro de alocacao\n");
+        free(buf);
+        free(jams);
+        task_reader_close(&reader);
+        return 0;
+    }
+
+    // RED é determinístico: um único estado vale para todas as rodadas
+    RedState red = {0.0, 0.0, 0};
+    int total = 0;
+
+    while (1) {
+        int n = 0;
+        while (n < chunk && task_reader_next(&reader, &buf[n]))
+            n++;
+        if (n == 0)
+            break;
+        assign_deadlines(buf, n, default_deadline_ms);
+
+        double rt;
+        for (int i = 0; i < n; ++i)
+            red_step(&red, &buf[i], &rt);
+        for (int k = 0; k < num_runs; ++k)
+            for (int i = 0; i < n; ++i)
+                jams_step(&jams[k], &buf[i], total + i, max_capacity_ms, rng, first_run + k, &rt);
+        total += n;
+    }
+
+    for (int k = 0; k < num_runs; ++k) {
+        Result r = {0.0, 0.0, 0, 0};
+        r.red_accepted = red.accepted;
+        if (red.accepted > 0) r.red_response_time = red.total_rt / red.accepted;
+        r.jams_accepted = jams[k].accepted;
+        if (jams[k].accepted > 0) r.jams_response_time = jams[k].total_rt / jams[k].accepted;
+        out[k] = r;
+    }
+    *out_tasks = total;
+
+    free(buf);
+    free(jams);
+    task_reader_close(&reader);
+    return total > 0;
+}
 
-            double r = (double)rand() / (RAND_MAX + 1.0);
-            if (r < prob) accepted = 1;
+/*
+ * Modo --workload: carga mista de várias streams, cada uma com o seu trace,
+ * período de chegada e deadline relativo. A tarefa k de uma stream é liberada
+ * em k * periodo_ms; as streams são intercaladas por tempo de liberação com um
+ * merge de k vias (heap mínimo com a próxima tarefa de cada stream), lendo os
+ * traces incrementalmente, sem montar o trace combinado. Empates vão para a
+ * stream dada primeiro. RED e JAMS avançam sobre a sequência intercalada como
+ * no modo --stream (todas as rodadas em lockstep) e os resultados são
+ * separados por stream. O modelo de aceitação não tem noção de tempo: o
+ * período só define a intercalação.
+ */
+typedef struct {
+    const char *path;
+    double period_ms;
+    double deadline_ms;
+    Rng rng;                 // sorteio dos values desta stream
+    TaskReader reader;
+    Task next;               // próxima tarefa da stream
+    double next_release_ms;  // liberação da próxima tarefa
+    int n;                   // tarefas liberadas
+} Stream;
+
+/* Acumuladores de uma stream em uma rodada */
+typedef struct {
+    int red_accepted;
+    double red_total_rt;
+    int jams_accepted;
+    double jams_total_rt;
+} StreamResult;
+
+int parse_workload(char *s, Stream *st) {
+    // trace:periodo:deadline; o caminho pode conter ':'
+    char *p_dl = strrchr(s, ':');
+    if (!p_dl || p_dl == s) return 0;
+    *p_dl = '\0';
+    char *p_per = strrchr(s, ':');
+    if (!p_per || p_per == s) return 0;
+    *p_per = '\0';
+    memset(st, 0, sizeof(*st));
+    st->path = s;
+    st->period_ms = atof(p_per + 1);
+    st->deadline_ms = atof(p_dl + 1);
+    return st->period_ms > 0.0 && st->deadline_ms > 0.0;
+}
+
+static inline int stream_before(const Stream *st, int a, int b) {
+    return st[a].next_release_ms < st[b].next_release_ms
+        || (st[a].next_release_ms == st[b].next_release_ms && a < b);
+}
+
+void stream_sift_down(const Stream *st, int heap[], int n, int i) {
+    for (;;) {
+        int min = i, l = 2 * i + 1, r = l + 1;
+        if (l < n && stream_before(st, heap[l], heap[min])) min = l;
+        if (r < n && stream_before(st, heap[r], heap[min])) min = r;
+        if (min == i) return;
+        int tmp = heap[i];
+        heap[i] = heap[min];
+        heap[min] = tmp;
+        i = min;
+    }
+}
+
+/* Lê a próxima tarefa da stream s; devolve 0 no fim do trace */
+int stream_advance(Stream *st) {
+    if (!task_reader_next(&st->reader, &st->next))
+        return 0;
+    st->next.deadline_ms = st->deadline_ms;
+    st->next_release_ms = st->n * st->period_ms;
+    return 1;
+}
+
+/* res: [num_runs][ns]; devolve o total de tarefas intercaladas */
+int run_workload(Stream st[], int ns, int first_run, int num_runs, double max_capacity_ms,
+                 uint64_t seed, StreamResult *res) {
+    int heap[MAX_STREAMS];
+    int heap_n = 0;
+    int ok = 1;
+    for (int s = 0; s < ns; ++s) {
+        st[s].rng = (Rng){ seed, (uint32_t)s + 1 };
+        st[s].n = 0;
+        if (!task_reader_open(&st[s].reader, st[s].path, &st[s].rng)) {
+            for (int k = 0; k < s; ++k)
+                task_reader_close(&st[k].reader);
+            return 0;
         }
+        if (stream_advance(&st[s]))
+            heap[heap_n++] = s;
+    }
+    for (int i = heap_n / 2 - 1; i >= 0; --i)
+        stream_sift_down(st, heap, heap_n, i);
+
+    JamsState *jams = calloc(num_runs, sizeof(JamsState));
+    if (!jams) {
+        fprintf(stderr, "Erro de alocacao\n");
+        ok = 0;
+        heap_n = 0;
+    }
 
-        if (accepted) {
-            current_load += C;
-            rt = current_load * OVERHEAD_JAMS;
-            res.jams_accepted++;
-            total_rt += rt;
+    // os sorteios do JAMS usam o índice na sequência intercalada
+    Rng rng = { seed, 0 };
+    RedState red = {0.0, 0.0, 0};
+    int total = 0;
+    while (heap_n > 0) {
+        int s = heap[0];
+        Task t = st[s].next;
+        t.id = total + 1;
+        st[s].n++;
+        if (!stream_advance(&st[s]))
+            heap[0] = heap[--heap_n];
+        stream_sift_down(st, heap, heap_n, 0);
+
+        double rt;
+        if (red_step(&red, &t, &rt)) {
+            for (int k = 0; k < num_runs; ++k) {
+                res[k * ns + s].red_accepted++;
+                res[k * ns + s].red_total_rt += rt;
+            }
         }
+        for (int k = 0; k < num_runs; ++k) {
+            if (jams_step(&jams[k], &t, total, max_capacity_ms, &rng, first_run + k, &rt)) {
+                res[k * ns + s].jams_accepted++;
+                res[k * ns + s].jams_total_rt += rt;
+            }
+        }
+        total++;
+    }
 
-        double load_after = current_load;
+    free(jams);
+    for (int s = 0; s < ns; ++s)
+        task_reader_close(&st[s].reader);
+    return ok ? total : 0;
+}
 
-        fprintf(log_task, "%d,JAMS,%d,%.5f,%.5f,%.5f\n",
-                i + 1, accepted, rt, load_before, load_after);
+/* Executa o modo --workload e escreve logs/workload.csv */
+int workload_main(Stream st[], int ns, int first_run, int num_runs, double max_capacity_ms,
+                  uint64_t seed) {
+    StreamResult *res = calloc((size_t)num_runs * ns, sizeof(StreamResult));
+    if (!res) {
+        fprintf(stderr, "Erro de alocacao\n");
+        return 0;
+    }
+    int total = run_workload(st, ns, first_run, num_runs, max_capacity_ms, seed, res);
+    if (total <= 0) {
+        fprintf(stderr, "Nenhuma tarefa carregada. Verifique os traces.\n");
+        free(res);
+        return 0;
     }
 
-    if (res.jams_accepted > 0) {
-        res.jams_response_time = total_rt / res.jams_accepted;
+    printf("Simulador RED vs JAMS - carga mista\n");
+    printf("Streams: %d, %d tarefas intercaladas\n", ns, total);
+    printf("Rodadas: %d, max_capacity(ms): %.1f\n", num_runs, max_capacity_ms);
+    printf("Semente: %llu\n\n", (unsigned long long)seed);
+
+    FILE *f = fopen("logs/workload.csv", "w");
+    if (f)
+        fprintf(f, "stream,trace,period_ms,deadline_ms,tasks,red_accepted,red_time_ms,"
+                   "jams_accepted,jams_accepted_ci95,jams_time_ms,jams_time_ci95\n");
+    else
+        fprintf(stderr, "Erro ao criar logs/workload.csv\n");
+
+    for (int s = 0; s < ns; ++s) {
+        // RED é determinístico: a rodada 0 vale para todas
+        const StreamResult *r0 = &res[s];
+        double red_rt = r0->red_accepted > 0 ? r0->red_total_rt / r0->red_accepted : 0.0;
+        RunningStats acc, rt;
+        stats_init(&acc);
+        stats_init(&rt);
+        for (int k = 0; k < num_runs; ++k) {
+            const StreamResult *r = &res[k * ns + s];
+            stats_add(&acc, r->jams_accepted);
+            stats_add(&rt, r->jams_accepted > 0 ? r->jams_total_rt / r->jams_accepted : 0.0);
+        }
+
+        printf("Stream %d: %s (periodo %.1f ms, deadline %.1f ms) -> %d tarefas\n",
+               s, st[s].path, st[s].period_ms, st[s].deadline_ms, st[s].n);
+        printf("  RED : Aceitou %d tarefas. Tempo Medio: %.2f ms\n", r0->red_accepted, red_rt);
+        printf("  JAMS: Aceitou %.2f +- %.2f tarefas. Tempo Medio: %.2f +- %.2f ms\n",
+               acc.mean, stats_ci95(&acc), rt.mean, stats_ci95(&rt));
+        if (f)
+            fprintf(f, "%d,%s,%.3f,%.3f,%d,%d,%.5f,%.2f,%.2f,%.5f,%.5f\n",
+                    s, st[s].path, st[s].period_ms, st[s].deadline_ms, st[s].n,
+                    r0->red_accepted, red_rt, acc.mean, stats_ci95(&acc), rt.mean, stats_ci95(&rt));
     }
-    return res;
+    if (f) {
+        fclose(f);
+        printf("\n[INFO] Resultados por stream exportados para 'logs/workload.csv'\n");
+    }
+
+    free(res);
+    return 1;
 }
 
 
 int main(int argc, char *argv[]) {
-    srand((unsigned)time(NULL) ^ (unsigned)getpid());
+    uint64_t seed = (uint64_t)time(NULL) ^ (uint64_t)getpid();
+    int replay_run = -1;
+    int stream_chunk = 0;
+    Stream streams[MAX_STREAMS];
+    int num_streams = 0;
+
+    // opções primeiro, depois os argumentos posicionais de sempre
+    int sweep = 0;
+    Range sweep_deadlines, sweep_capacities;
+    int num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char *pos[4];
+    int npos = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--sweep") == 0) {
+            if (i + 2 >= argc || !parse_range(argv[i + 1], &sweep_deadlines)
+                || !parse_range(argv[i + 2], &sweep_capacities)) {
+                fprintf(stderr, "--sweep espera dl_ini:dl_fim:passo cap_ini:cap_fim:passo\n");
+                return 1;
+            }
+            sweep = 1;
+            i += 2;
+        } else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) {
+            if (++i >= argc) { usage(argv[0]); return 1; }
+            num_threads = atoi(argv[i]);
+        } else if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--seed") == 0) {
+            if (++i >= argc) { usage(argv[0]); return 1; }
+            seed = strtoull(argv[i], NULL, 0);
+        } else if (strcmp(argv[i], "--run") == 0) {
+            if (++i >= argc) { usage(argv[0]); return 1; }
+            replay_run = atoi(argv[i]);
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            if (++i >= argc) { usage(argv[0]); return 1; }
+            stream_chunk = atoi(argv[i]);
+        } else if (strcmp(argv[i], "--workload") == 0) {
+            if (++i >= argc || num_streams == MAX_STREAMS
+                || !parse_workload(argv[i], &streams[num_streams])) {
+                fprintf(stderr, "--workload espera trace:periodo_ms:deadline_ms (ate %d streams)\n", MAX_STREAMS);
+                return 1;
+            }
+            num_streams++;
+        } else if (npos < 4) {
+            pos[npos++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
 
-    if (argc < 2) {
+    if (num_streams > 0) {
+        // sem csv_path: [num_runs] [max_capacity_ms]
+        int num_runs = (npos >= 1) ? atoi(pos[0]) : DEFAULT_NUM_RUNS;
+        double max_capacity_ms = (npos >= 2) ? atof(pos[1]) : DEFAULT_MAX_CAPACITY_MS;
+        if (num_runs <= 0) num_runs = DEFAULT_NUM_RUNS;
+        int first_run = 0;
+        if (replay_run >= 0) {
+            first_run = replay_run;
+            num_runs = 1;
+        }
+        return workload_main(streams, num_streams, first_run, num_runs, max_capacity_ms, seed) ? 0 : 2;
+    }
+
+    if (npos < 1) {
         usage(argv[0]);
         return 1;
     }
 
-    const char *csv_path = argv[1];
-    int num_runs = (argc >= 3) ? atoi(argv[2]) : DEFAULT_NUM_RUNS;
-    double default_deadline_ms = (argc >= 4) ? atof(argv[3]) : DEFAULT_DEADLINE_MS;
-    double max_capacity_ms = (argc >= 5) ? atof(argv[4]) : DEFAULT_MAX_CAPACITY_MS;
+    const char *csv_path = pos[0];
+    int num_runs = (npos >= 2) ? atoi(pos[1]) : DEFAULT_NUM_RUNS;
+    double default_deadline_ms = (npos >= 3) ? atof(pos[2]) : DEFAULT_DEADLINE_MS;
+    double max_capacity_ms = (npos >= 4) ? atof(pos[3]) : DEFAULT_MAX_CAPACITY_MS;
 
     if (num_runs <= 0) num_runs = DEFAULT_NUM_RUNS;
+    if (num_threads <= 0) num_threads = 1;
+    if (num_threads > MAX_SWEEP_THREADS) num_threads = MAX_SWEEP_THREADS;
+
+    // cada rodada só depende de (seed, run): --run k reproduz a rodada k sozinha,
+    // também na varredura e no modo lote
+    int first_run = 0;
+    if (replay_run >= 0) {
+        first_run = replay_run;
+        num_runs = 1;
+    }
+
+    if (stream_chunk > 0 && sweep) {
+        fprintf(stderr, "--stream nao se combina com --sweep\n");
+        return 1;
+    }
+
+    char **batch_paths = NULL;
+    int num_batch = collect_traces(csv_path, &batch_paths);
+    if (num_batch >= 0) {
+        if (sweep || stream_chunk > 0) {
+            fprintf(stderr, "%s espera um unico trace, nao um diretorio ou glob: %s\n",
+                    sweep ? "--sweep" : "--stream", csv_path);
+            for (int i = 0; i < num_batch; ++i) free(batch_paths[i]);
+            free(batch_paths);
+            return 1;
+        }
+        if (num_batch == 0) {
+            fprintf(stderr, "Nenhum trace encontrado em %s\n", csv_path);
+            return 2;
+        }
+        int ok = run_batch(batch_paths, num_batch, first_run, num_runs, default_deadline_ms,
+                           max_capacity_ms, num_threads, seed);
+        for (int i = 0; i < num_batch; ++i) free(batch_paths[i]);
+        free(batch_paths);
+        return ok ? 0 : 2;
+    }
+
+    Rng rng = { seed, 0 };
 
     Task *tasks = NULL;
-    int total_tasks = load_tasks_from_csv(csv_path, &tasks);
+    Result *stream_res = NULL;
+    int total_tasks;
+    if (stream_chunk > 0) {
+        stream_res = malloc(sizeof(Result) * num_runs);
+        if (!stream_res) {
+            fprintf(stderr, "Erro de alocacao\n");
+            return 2;
+        }
+        if (!run_stream(csv_path, stream_chunk, first_run, num_runs, default_deadline_ms,
+                        max_capacity_ms, &rng, stream_res, &total_tasks))
+            total_tasks = 0;
+    } else {
+        total_tasks = load_tasks_from_csv(csv_path, &tasks, &rng);
+    }
     if (total_tasks <= 0) {
         fprintf(stderr, "Nenhuma tarefa carregada. Verifique o CSV.\n");
+        free(stream_res);
         return 2;
     }
 
+    if (sweep) {
+        // a tabela fica sem deadlines: cada ponto usa o seu
+        int ok = run_sweep(tasks, total_tasks, first_run, num_runs, &sweep_deadlines,
+                           &sweep_capacities, num_threads, &rng);
+        free(tasks);
+        return ok ? 0 : 3;
+    }
+
     // Aqui usamos todas as tarefas lidas. Se preferir limitar, ajuste total_tasks.
-    assign_deadlines(tasks, total_tasks, default_deadline_ms);
+    if (tasks)
+        assign_deadlines(tasks, total_tasks, default_deadline_ms);
 
     double red_resp_sum = 0.0, jams_resp_sum = 0.0;
     long red_acc_sum = 0, jams_acc_sum = 0;
 
+    // estatísticas do tempo médio por rodada, calculadas durante a execução
+    RunningStats red_stats, jams_stats;
+    stats_init(&red_stats);
+    stats_init(&jams_stats);
+
     printf("Simulador RED vs JAMS\n");
     printf("CSV: %s -> %d tarefas lidas\n", csv_path, total_tasks);
-    printf("Rodadas: %d, deadline(ms) default: %.1f, max_capacity(ms): %.1f\n\n",
+    printf("Rodadas: %d, deadline(ms) default: %.1f, max_capacity(ms): %.1f\n",
            num_runs, default_deadline_ms, max_capacity_ms);
+    printf("Semente: %llu\n\n", (unsigned long long)seed);
 
     FILE *f_runs = fopen("logs/log_runs.csv", "w");
-    FILE *f_tasks = fopen("logs/log_tasks.csv", "w");
+    FILE *f_tasks = stream_res ? NULL : fopen("logs/log_tasks.csv", "w");
 
     fprintf(f_runs, "run,algorithm,accepted,time_ms\n");
-    fprintf(f_tasks, "task_id,algorithm,accepted,rt_ms,load_before,load_after\n");
+    if (f_tasks)
+        fprintf(f_tasks, "task_id,algorithm,accepted,rt_ms,load_before,load_after\n");
 
     // Realiza num_runs rodadas para obter média (JAMS é probabilístico)
-    for (int run = 0; run < num_runs; ++run) {
+    for (int run = first_run; run < first_run + num_runs; ++run) {
         // podem reembaralhar valores para variar ordens — opcional:
         // shuffle(tasks, total_tasks); // se implementar shuffle
 
-        // Result r_red = simulate_RED(tasks, total_tasks);
-        // Result r_jams = simulate_JAMS(tasks, total_tasks, max_capacity_ms);
 
-        Result r_red = simulate_RED_logged(tasks, total_tasks, f_tasks);
-        Result r_jams = simulate_JAMS_logged(tasks, total_tasks, max_capacity_ms, f_tasks);
+        Result r_red, r_jams;
+        if (stream_res) {
+            // já simulada em blocos por run_stream()
+            r_red = r_jams = stream_res[run - first_run];
+        } else {
+            r_red = simulate_RED_logged(tasks, total_tasks, f_tasks);
+            r_jams = simulate_JAMS_logged(tasks, total_tasks, max_capacity_ms, &rng, run, f_tasks);
+        }
 
         fprintf(f_runs, "%d,RED,%d,%.5f\n", run, r_red.red_accepted, r_red.red_response_time);
         fprintf(f_runs, "%d,JAMS,%d,%.5f\n", run, r_jams.jams_accepted, r_jams.jams_response_time);
@@ -334,10 +1169,24 @@ int main(int argc, char *argv[]) {
         jams_resp_sum += r_jams.jams_response_time;
         red_acc_sum += r_red.red_accepted;
         jams_acc_sum += r_jams.jams_accepted;
+
+        stats_add(&red_stats, r_red.red_response_time);
+        stats_add(&jams_stats, r_jams.jams_response_time);
     }
 
     fclose(f_runs);
-    fclose(f_tasks);
+    if (f_tasks)
+        fclose(f_tasks);
+
+    FILE *f_stats = fopen("logs/stats.csv", "w");
+    if (f_stats) {
+        stats_write_header(f_stats);
+        stats_write_row(f_stats, "RED", &red_stats);
+        stats_write_row(f_stats, "JAMS", &jams_stats);
+        fclose(f_stats);
+    } else {
+        fprintf(stderr, "Erro ao criar logs/stats.csv\n");
+    }
 
     double avg_red_resp = red_resp_sum / num_runs;
     double avg_jams_resp = jams_resp_sum / num_runs;
@@ -367,5 +1216,6 @@ int main(int argc, char *argv[]) {
     }
 
     free(tasks);
+    free(stream_res);
     return 0;
 }
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "admit_proto.h"
+
+/*
+ * Cliente de benchmark do red_daemon: envia n jobs periódicos mantendo até
+ * `profundidade` requisições em voo e mede a latência de cada decisão (do
+ * envio do lote à chegada da resposta) e a vazão.
+ */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return 1;
+}
+
+void usage(const char *prog) {
+    printf("Uso: %s [-n jobs] [-d profundidade] [-p periodo] [-c exec] [-D deadline_rel] [socket]\n", prog);
+    printf("Padrao: 1000000 jobs, profundidade 1, periodo 100, exec 50, deadline = periodo, socket %s\n",
+           ADMIT_DEFAULT_SOCKET);
+}
+
+int main(int argc, char **argv) {
+    size_t n = 1000000;
+    size_t depth = 1;
+    uint64_t period = 100, exec = 50, rel_deadline = 0;
+    const char *path = ADMIT_DEFAULT_SOCKET;
+    int i;
+
+    for (i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        if (strcmp(argv[i], "-n") == 0)
+            n = strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-d") == 0)
+            depth = strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-p") == 0)
+            period = strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-c") == 0)
+            exec = strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-D") == 0)
+            rel_deadline = strtoull(argv[i + 1], NULL, 10);
+        else
+            break;
+    }
+    if (i < argc && argv[i][0] == '-') {
+        usage(argv[0]);
+        return 1;
+    }
+    if (i < argc)
+        path = argv[i];
+    if (n == 0 || depth == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (rel_deadline == 0)
+        rel_deadline = period;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Erro conectando ao red_daemon");
+        return 1;
+    }
+
+    admit_req_t *req = malloc(depth * sizeof(admit_req_t));
+    uint64_t *sent = malloc(n * sizeof(uint64_t));
+    uint64_t *lat = malloc(n * sizeof(uint64_t));
+    admit_resp_t resp[1024];
+    if (!req || !sent || !lat) {
+        fprintf(stderr, "Erro de alocacao\n");
+        return 1;
+    }
+
+    // começa de um escalonador vazio: os releases do benchmark partem de 0
+    admit_req_t reset;
+    memset(&reset, 0, sizeof(reset));
+    reset.op = ADMIT_OP_RESET;
+    if (!write_all(fd, &reset, sizeof(reset)) || read(fd, resp, sizeof(admit_resp_t)) != sizeof(admit_resp_t)) {
+        fprintf(stderr, "Erro no reset do red_daemon\n");
+        return 1;
+    }
+
+    size_t next = 0, done = 0, accepted = 0, errors = 0;
+    size_t partial = 0;   // bytes de uma resposta incompleta
+    uint32_t rng = 2463534242u;
+    uint64_t beg = now_ns();
+
+    while (done < n) {
+        size_t k = 0;
+        while (next < n && next - done < depth) {
+            // exec sorteado em [exec/2, 3*exec/2)
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            admit_req_t *r = &req[k++];
+            memset(r, 0, sizeof(*r));
+            r->seq = (uint32_t)next;
+            r->op = ADMIT_OP_ADMIT;
+            r->value = 10;
+            r->job_id = (int32_t)next;
+            r->release_time = next * period;
+            r->exec_time = exec / 2 + (exec ? rng % exec : 0);
+            r->abs_deadline = r->release_time + rel_deadline;
+            next++;
+        }
+        if (k > 0) {
+            uint64_t t = now_ns();
+            for (size_t j = 0; j < k; j++)
+                sent[req[j].seq] = t;
+            if (!write_all(fd, req, k * sizeof(admit_req_t))) {
+                perror("write");
+                return 1;
+            }
+        }
+
+        ssize_t r = read(fd, (char *)resp + partial, sizeof(resp) - partial);
+        if (r <= 0) {
+            if (r < 0 && errno == EINTR)
+                continue;
+            fprintf(stderr, "Conexao encerrada pelo red_daemon\n");
+            return 1;
+        }
+        uint64_t t = now_ns();
+        size_t bytes = partial + (size_t)r;
+        size_t m = bytes / sizeof(admit_resp_t);
+        for (size_t j = 0; j < m; j++) {
+            lat[done++] = t - sent[resp[j].seq];
+            accepted += resp[j].verdict == ADMIT_ACCEPT;
+            errors += resp[j].verdict == ADMIT_ERROR;
+        }
+        partial = bytes - m * sizeof(admit_resp_t);
+        memmove(resp, (char *)resp + m * sizeof(admit_resp_t), partial);
+    }
+
+    double elapsed_s = (now_ns() - beg) / 1e9;
+    close(fd);
+
+    qsort(lat, n, sizeof(uint64_t), cmp_u64);
+    double sum = 0;
+    for (size_t j = 0; j < n; j++)
+        sum += lat[j];
+
+    printf("Decisoes: %zu (aceitos: %zu, rejeitados: %zu, erros: %zu)\n",
+           n, accepted, n - accepted - errors, errors);
+    printf("Profundidade do pipeline: %zu\n", depth);
+    printf("Vazao: %.0f decisoes/s\n", n / elapsed_s);
+    printf("Latencia (us): media %.2f p50 %.2f p99 %.2f p99.9 %.2f max %.2f\n",
+           sum / n / 1e3, lat[n / 2] / 1e3, lat[(size_t)(n * 0.99)] / 1e3,
+           lat[(size_t)(n * 0.999)] / 1e3, lat[n - 1] / 1e3);
+
+    free(req);
+    free(sent);
+    free(lat);
+    return 0;
+}
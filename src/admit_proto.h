@@ -0,0 +1,47 @@
+#ifndef ADMIT_PROTO_H
+#define ADMIT_PROTO_H
+
+#include <stdint.h>
+
+/*
+ * Admission protocol of red_daemon: fixed-size binary frames in host byte
+ * order (local sockets only). A client may write any number of requests
+ * before reading; responses come back in request order and echo seq, so
+ * requests can be pipelined.
+ *
+ * Times are in trace ticks (microseconds for traces made by trace_conv).
+ * Jobs are expected in release order; a job released in the past is
+ * released at the daemon's current time.
+ */
+
+#define ADMIT_OP_ADMIT 1   // run the admission policy on the job
+#define ADMIT_OP_RESET 2   // drop all state (job fields are ignored)
+
+#define ADMIT_REJECT 0
+#define ADMIT_ACCEPT 1
+#define ADMIT_ERROR  2     // unknown op or malformed frame
+
+typedef struct {
+    uint32_t seq;          // echoed in the response
+    uint16_t op;
+    uint16_t value;        // job value, used by the JAMS policy
+    int32_t job_id;
+    uint32_t reserved;
+    uint64_t release_time;
+    uint64_t exec_time;
+    uint64_t abs_deadline;
+} admit_req_t;
+
+typedef struct {
+    uint32_t seq;
+    int32_t job_id;
+    uint32_t verdict;      // ADMIT_ACCEPT, ADMIT_REJECT or ADMIT_ERROR
+    uint32_t queued;       // jobs in the ready set after the decision
+} admit_resp_t;
+
+_Static_assert(sizeof(admit_req_t) == 40, "admit_req_t must be 40 bytes");
+_Static_assert(sizeof(admit_resp_t) == 16, "admit_resp_t must be 16 bytes");
+
+#define ADMIT_DEFAULT_SOCKET "/tmp/red_daemon.sock"
+
+#endif
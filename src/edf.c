@@ -0,0 +1,159 @@
+#include "edf.h"
+#include <stdlib.h>
+
+#define EDF_REJQ_SIZE 1024
+
+int edf_init(edf_sched_t *e, size_t cap, int admission) {
+    if (!red_ready_init(&e->ready, cap, EDF_REJQ_SIZE))
+        return 0;
+    e->now = 0;
+    e->admission = admission;
+    e->released = e->accepted = e->rejected = e->reclaimed = 0;
+    e->reject_dropped = 0;
+    e->completed = e->missed_deadlines = e->preemptions = 0;
+    e->events = e->idle_time = 0;
+    return 1;
+}
+
+void edf_cleanup(edf_sched_t *e) {
+    red_ready_free(&e->ready);
+}
+
+/*
+ * Time the running job still needs: its remaining declared time, less what it
+ * will not use when its actual execution time is shorter than the declared.
+ */
+static inline uint64_t edf_left(const red_node_t *n) {
+    uint64_t actual = n->job.actual_time;
+    if (actual == 0 || actual >= n->job.exec_time)
+        return n->remaining;
+    uint64_t unused = n->job.exec_time - actual;
+    return n->remaining > unused ? n->remaining - unused : 0;
+}
+
+/*
+ * Runs the EDF schedule up to time t: the earliest-deadline ready job always
+ * holds the CPU, and time jumps from one completion to the next.
+ */
+void edf_advance(edf_sched_t *e, uint64_t t) {
+    for (;;) {
+        red_node_t *top = red_ready_min(&e->ready);
+        if (top == NULL) {
+            if (e->now < t) {
+                e->idle_time += t - e->now;
+                e->now = t;
+            }
+            break;
+        }
+        uint64_t left = edf_left(top);
+        if (e->now + left > t) {
+            red_ready_consume(&e->ready, t - e->now);
+            e->now = t;
+            break;
+        }
+        e->now += left;
+        if (e->now > top->job.abs_deadline)
+            e->missed_deadlines++;
+        e->completed++;
+        e->events++;
+        uint64_t unused = top->remaining - left;
+        red_ready_pop_min(&e->ready);
+        if (unused > 0)
+            red_ready_shift(&e->ready, unused);
+
+        if (e->admission && e->ready.rejq_size > 0
+            && red_ready_reclaim(&e->ready, e->released + e->reclaimed + 1, e->now, &e->reject_dropped))
+            e->reclaimed++;
+    }
+}
+
+/* RED test and insertion of a job released at e->now */
+static int edf_admit(edf_sched_t *e, const job_t *j) {
+    red_node_t *top = red_ready_min(&e->ready);
+    int started = top && top->remaining < top->job.exec_time;
+
+    uint64_t seq = e->released + e->reclaimed;
+    if (!red_ready_admit(&e->ready, j, seq, e->now, e->admission)) {
+        e->rejected++;
+        if (e->admission)
+            red_ready_reject(&e->ready, j);
+        return 0;
+    }
+
+    if (started && red_ready_min(&e->ready)->seq == seq)
+        e->preemptions++;
+    e->accepted++;
+    return 1;
+}
+
+/*
+ * Releases job j: advances the schedule to its release time (jobs are
+ * expected in release order; a job released in the past is released now),
+ * runs the RED test and inserts it into the ready set, or into the reject
+ * queue. Returns 1 if the job was accepted.
+ */
+int edf_release(edf_sched_t *e, const job_t *j) {
+    if (j->release_time > e->now)
+        edf_advance(e, j->release_time);
+    e->released++;
+    e->events++;
+    return edf_admit(e, j);
+}
+
+/*
+ * Releases the first n jobs of a packed burst (at most jobs->n) in arrival
+ * order, with the same outcome as calling edf_release() on each. out_mask[i]
+ * is set to 1 for accepted jobs and 0 for rejected ones; returns the number
+ * of accepted jobs.
+ *
+ * now only grows while releasing, so a job that does not fit on an idle CPU
+ * at max(now at the start of the burst, its release) cannot pass the RED test
+ * later: a first branch-free pass over the packed columns (vectorized by the
+ * compiler) rejects those. The second pass runs the schedule through the
+ * burst and goes to the treap only for the survivors; the others just join
+ * the reject queue, in the same order as with edf_release().
+ */
+size_t red_accept_batch(const red_batch_t *jobs, size_t n, edf_sched_t *e, uint8_t *out_mask) {
+    const uint64_t *restrict rel = jobs->release_time;
+    const uint64_t *restrict exec = jobs->exec_time;
+    const uint64_t *restrict dl = jobs->abs_deadline;
+    uint8_t *restrict mask = out_mask;
+    uint64_t now = e->now;
+
+    if (n > jobs->n)
+        n = jobs->n;
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t start = rel[i] > now ? rel[i] : now;
+        mask[i] = !e->admission | (start + exec[i] <= dl[i]);
+    }
+
+    size_t accepted = 0;
+    for (size_t i = 0; i < n; i++) {
+        job_t j = {jobs->job_id[i], rel[i], exec[i], dl[i], jobs->actual_time[i]};
+        if (j.release_time > e->now)
+            edf_advance(e, j.release_time);
+        e->released++;
+        e->events++;
+        if (mask[i]) {
+            mask[i] = edf_admit(e, &j);
+        } else {
+            e->rejected++;
+            red_ready_reject(&e->ready, &j);
+        }
+        accepted += mask[i];
+    }
+    return accepted;
+}
+
+/* Runs the schedule until the ready set is empty */
+void edf_drain(edf_sched_t *e) {
+    red_node_t *top;
+    while ((top = red_ready_min(&e->ready)) != NULL)
+        edf_advance(e, e->now + edf_left(top));
+}
+
+/* Remaining work of the ready set */
+uint64_t edf_backlog(const edf_sched_t *e) {
+    return e->ready.root < 0 ? 0 : e->ready.nodes[e->ready.root].sum_work;
+}
@@ -0,0 +1,33 @@
+#ifndef EDF_H
+#define EDF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "red.h"
+
+typedef struct {
+    red_ready_t ready;   // ready set ordered by (abs_deadline, arrival seq)
+    uint64_t now;
+    int admission;       // 1: RED acceptance test over the ready set, 0: plain EDF
+
+    uint64_t released;
+    uint64_t accepted;
+    uint64_t rejected;
+    uint64_t reclaimed;  // rejected jobs later readmitted from the reject queue
+    size_t reject_dropped; // rejected jobs that expired in the reject queue
+    uint64_t completed;
+    uint64_t missed_deadlines;
+    uint64_t preemptions;
+    uint64_t events;     // releases + completions
+    uint64_t idle_time;
+} edf_sched_t;
+
+int edf_init(edf_sched_t *e, size_t cap, int admission);
+void edf_cleanup(edf_sched_t *e);
+void edf_advance(edf_sched_t *e, uint64_t t);
+int edf_release(edf_sched_t *e, const job_t *j);
+size_t red_accept_batch(const red_batch_t *jobs, size_t n, edf_sched_t *e, uint8_t *out_mask);
+void edf_drain(edf_sched_t *e);
+uint64_t edf_backlog(const edf_sched_t *e);
+
+#endif
@@ -3,13 +3,17 @@
 #include <string.h>
 #include <stdlib.h>
 
+/* job_id,release,exec,deadline[,actual]: actual is the time the job really
+   runs, when it completes earlier than its declared exec */
 int parse_job(const char *line, job_t *j) {
+    j->actual_time = 0;
     return sscanf(
-        line, "%d,%lu,%lu,%lu",
+        line, "%d,%lu,%lu,%lu,%lu",
         &j->job_id,
         &j->release_time,
         &j->exec_time,
-        &j->abs_deadline
-    ) == 4;
+        &j->abs_deadline,
+        &j->actual_time
+    ) >= 4;
 }
 
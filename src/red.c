@@ -1,5 +1,6 @@
 #include "red.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 void red_init(red_state_t *s) {
@@ -26,3 +27,320 @@ void red_execute(job_t *j, red_state_t *s) {
     s->executed_jobs++;
 }
 
+int red_batch_init(red_batch_t *b, size_t cap) {
+    b->n = 0;
+    b->cap = cap;
+    b->job_id = malloc(cap * sizeof(*b->job_id));
+    b->release_time = malloc(cap * sizeof(*b->release_time));
+    b->exec_time = malloc(cap * sizeof(*b->exec_time));
+    b->abs_deadline = malloc(cap * sizeof(*b->abs_deadline));
+    b->actual_time = malloc(cap * sizeof(*b->actual_time));
+    if (!b->job_id || !b->release_time || !b->exec_time || !b->abs_deadline || !b->actual_time) {
+        red_batch_free(b);
+        return 0;
+    }
+    return 1;
+}
+
+void red_batch_free(red_batch_t *b) {
+    free(b->job_id);
+    free(b->release_time);
+    free(b->exec_time);
+    free(b->abs_deadline);
+    free(b->actual_time);
+    b->job_id = NULL;
+    b->release_time = b->exec_time = b->abs_deadline = b->actual_time = NULL;
+    b->n = b->cap = 0;
+}
+
+/* Copies n jobs into the packed layout (n must fit in the batch capacity) */
+int red_batch_pack(red_batch_t *b, const job_t *jobs, size_t n) {
+    if (n > b->cap)
+        return 0;
+
+    for (size_t i = 0; i < n; i++) {
+        b->job_id[i] = jobs[i].job_id;
+        b->release_time[i] = jobs[i].release_time;
+        b->exec_time[i] = jobs[i].exec_time;
+        b->abs_deadline[i] = jobs[i].abs_deadline;
+        b->actual_time[i] = jobs[i].actual_time;
+    }
+    b->n = n;
+    return 1;
+}
+
+/*
+ * Full RED acceptance test.
+ *
+ * Under EDF, the slack of a ready job i is d_i - now - W(d_i), where W(d) is
+ * the remaining work of the ready jobs with deadline <= d. While the CPU is
+ * busy both now and W(d_i) move by the same amount, so the slack only changes
+ * when a job is inserted: a new job j delays exactly the jobs with a later
+ * deadline by C_j. Splitting the treap at d_j therefore gives W(d_j) as the
+ * left sum and the tightest later job as the right minimum slack, and the
+ * insertion is a lazy "-C_j" on the right part.
+ */
+
+#define RED_NIL (-1)
+
+static inline uint64_t red_sum(const red_ready_t *r, int32_t t) {
+    return t == RED_NIL ? 0 : r->nodes[t].sum_work;
+}
+
+static inline int64_t red_min(const red_ready_t *r, int32_t t) {
+    return t == RED_NIL ? INT64_MAX : r->nodes[t].min_slack;
+}
+
+static inline void red_apply(red_ready_t *r, int32_t t, int64_t delta) {
+    if (t == RED_NIL)
+        return;
+    red_node_t *n = &r->nodes[t];
+    n->slack += delta;
+    n->min_slack += delta;
+    n->lazy += delta;
+}
+
+static inline void red_push(red_ready_t *r, int32_t t) {
+    red_node_t *n = &r->nodes[t];
+    if (n->lazy != 0) {
+        red_apply(r, n->left, n->lazy);
+        red_apply(r, n->right, n->lazy);
+        n->lazy = 0;
+    }
+}
+
+static inline void red_pull(red_ready_t *r, int32_t t) {
+    red_node_t *n = &r->nodes[t];
+    n->sum_work = n->remaining + red_sum(r, n->left) + red_sum(r, n->right);
+    int64_t m = n->slack;
+    int64_t ml = red_min(r, n->left);
+    int64_t mr = red_min(r, n->right);
+    if (ml < m)
+        m = ml;
+    if (mr < m)
+        m = mr;
+    n->min_slack = m;
+}
+
+static inline int red_key_less(const red_node_t *n, uint64_t dl, uint64_t seq) {
+    return n->job.abs_deadline < dl || (n->job.abs_deadline == dl && n->seq < seq);
+}
+
+/* Splits t into keys < (dl, seq) and keys >= (dl, seq) */
+static void red_split(red_ready_t *r, int32_t t, uint64_t dl, uint64_t seq, int32_t *lo, int32_t *hi) {
+    if (t == RED_NIL) {
+        *lo = *hi = RED_NIL;
+        return;
+    }
+    red_push(r, t);
+    red_node_t *n = &r->nodes[t];
+    if (red_key_less(n, dl, seq)) {
+        red_split(r, n->right, dl, seq, &n->right, hi);
+        *lo = t;
+    } else {
+        red_split(r, n->left, dl, seq, lo, &n->left);
+        *hi = t;
+    }
+    red_pull(r, t);
+}
+
+static int32_t red_merge(red_ready_t *r, int32_t a, int32_t b) {
+    if (a == RED_NIL)
+        return b;
+    if (b == RED_NIL)
+        return a;
+    if (r->nodes[a].prio > r->nodes[b].prio) {
+        red_push(r, a);
+        r->nodes[a].right = red_merge(r, r->nodes[a].right, b);
+        red_pull(r, a);
+        return a;
+    }
+    red_push(r, b);
+    r->nodes[b].left = red_merge(r, a, r->nodes[b].left);
+    red_pull(r, b);
+    return b;
+}
+
+int red_ready_init(red_ready_t *r, size_t cap, size_t rejq_cap) {
+    if (cap == 0)
+        cap = 1;
+    if (rejq_cap == 0)
+        rejq_cap = 1;
+    r->nodes = malloc(cap * sizeof(red_node_t));
+    r->rejq = malloc(rejq_cap * sizeof(job_t));
+    if (!r->nodes || !r->rejq) {
+        free(r->nodes);
+        free(r->rejq);
+        return 0;
+    }
+    r->cap = cap;
+    r->size = 0;
+    r->root = RED_NIL;
+    r->free_list = RED_NIL;
+    for (size_t i = cap; i-- > 0;) {
+        r->nodes[i].left = r->free_list;
+        r->free_list = (int32_t)i;
+    }
+    r->rng = 2463534242u;
+    r->rejq_cap = rejq_cap;
+    r->rejq_head = r->rejq_size = 0;
+    return 1;
+}
+
+void red_ready_free(red_ready_t *r) {
+    free(r->nodes);
+    free(r->rejq);
+    r->nodes = NULL;
+    r->rejq = NULL;
+    r->cap = r->size = r->rejq_cap = r->rejq_size = 0;
+    r->root = RED_NIL;
+    r->free_list = RED_NIL;
+}
+
+static int32_t red_node_alloc(red_ready_t *r) {
+    if (r->free_list == RED_NIL) {
+        size_t cap = r->cap * 2;
+        red_node_t *tmp = realloc(r->nodes, cap * sizeof(red_node_t));
+        if (!tmp)
+            return RED_NIL;
+        r->nodes = tmp;
+        for (size_t i = cap; i-- > r->cap;) {
+            r->nodes[i].left = r->free_list;
+            r->free_list = (int32_t)i;
+        }
+        r->cap = cap;
+    }
+    int32_t t = r->free_list;
+    r->free_list = r->nodes[t].left;
+    return t;
+}
+
+/*
+ * Inserts job j released at now (seq must be larger than any seq in the
+ * ready set). With test != 0 the job is inserted only if it passes the RED
+ * test: it finishes by its deadline and no ready job misses its own.
+ * Returns 1 if inserted.
+ */
+int red_ready_admit(red_ready_t *r, const job_t *j, uint64_t seq, uint64_t now, int test) {
+    int32_t lo, hi;
+    red_split(r, r->root, j->abs_deadline, seq, &lo, &hi);
+
+    int64_t slack = (int64_t)j->abs_deadline - (int64_t)(now + red_sum(r, lo) + j->exec_time);
+    if (test && (slack < 0 || red_min(r, hi) < (int64_t)j->exec_time)) {
+        r->root = red_merge(r, lo, hi);
+        return 0;
+    }
+
+    int32_t t = red_node_alloc(r);
+    if (t == RED_NIL) {
+        r->root = red_merge(r, lo, hi);
+        return 0;
+    }
+    red_node_t *n = &r->nodes[t];
+    n->job = *j;
+    n->seq = seq;
+    n->remaining = j->exec_time;
+    n->slack = slack;
+    n->lazy = 0;
+    r->rng ^= r->rng << 13;
+    r->rng ^= r->rng >> 17;
+    r->rng ^= r->rng << 5;
+    n->prio = r->rng;
+    n->left = n->right = RED_NIL;
+    red_pull(r, t);
+
+    red_apply(r, hi, -(int64_t)j->exec_time);
+    r->root = red_merge(r, red_merge(r, lo, t), hi);
+    r->size++;
+    return 1;
+}
+
+/* Earliest-deadline job (the one EDF runs), or NULL if the set is empty */
+red_node_t *red_ready_min(red_ready_t *r) {
+    int32_t t = r->root;
+    if (t == RED_NIL)
+        return NULL;
+    for (;;) {
+        red_push(r, t);
+        if (r->nodes[t].left == RED_NIL)
+            return &r->nodes[t];
+        t = r->nodes[t].left;
+    }
+}
+
+static void red_consume_rec(red_ready_t *r, int32_t t, uint64_t dt) {
+    red_push(r, t);
+    if (r->nodes[t].left == RED_NIL)
+        r->nodes[t].remaining -= dt;
+    else
+        red_consume_rec(r, r->nodes[t].left, dt);
+    red_pull(r, t);
+}
+
+/* Serves dt units of the earliest-deadline job (dt <= its remaining time) */
+void red_ready_consume(red_ready_t *r, uint64_t dt) {
+    if (r->root != RED_NIL && dt > 0)
+        red_consume_rec(r, r->root, dt);
+}
+
+static int32_t red_pop_rec(red_ready_t *r, int32_t t) {
+    red_push(r, t);
+    red_node_t *n = &r->nodes[t];
+    if (n->left == RED_NIL) {
+        int32_t right = n->right;
+        n->left = r->free_list;
+        r->free_list = t;
+        return right;
+    }
+    n->left = red_pop_rec(r, n->left);
+    red_pull(r, t);
+    return t;
+}
+
+/* Removes the earliest-deadline job */
+void red_ready_pop_min(red_ready_t *r) {
+    if (r->root == RED_NIL)
+        return;
+    r->root = red_pop_rec(r, r->root);
+    r->size--;
+}
+
+/* A job completed dt earlier than declared: every ready job now finishes dt
+   earlier, so their slack grows by dt */
+void red_ready_shift(red_ready_t *r, uint64_t dt) {
+    red_apply(r, r->root, (int64_t)dt);
+}
+
+/* Appends a rejected job to the reject queue, evicting the oldest when full */
+void red_ready_reject(red_ready_t *r, const job_t *j) {
+    if (r->rejq_size == r->rejq_cap) {
+        r->rejq_head = (r->rejq_head + 1) % r->rejq_cap;
+        r->rejq_size--;
+    }
+    r->rejq[(r->rejq_head + r->rejq_size) % r->rejq_cap] = *j;
+    r->rejq_size++;
+}
+
+/*
+ * Tries to readmit the oldest rejected job at time now, e.g. after a job
+ * completed earlier than its declared execution time. Jobs that can no longer
+ * meet their deadline are dropped from the queue (counted in *dropped).
+ * Returns 1 if a job was readmitted (with arrival order seq).
+ */
+int red_ready_reclaim(red_ready_t *r, uint64_t seq, uint64_t now, size_t *dropped) {
+    while (r->rejq_size > 0) {
+        job_t *j = &r->rejq[r->rejq_head];
+        if (now + j->exec_time > j->abs_deadline) {
+            r->rejq_head = (r->rejq_head + 1) % r->rejq_cap;
+            r->rejq_size--;
+            (*dropped)++;
+            continue;
+        }
+        if (!red_ready_admit(r, j, seq, now, 1))
+            return 0;
+        r->rejq_head = (r->rejq_head + 1) % r->rejq_cap;
+        r->rejq_size--;
+        return 1;
+    }
+    return 0;
+}
@@ -2,12 +2,14 @@
 #define RED_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 typedef struct {
     int job_id;
     uint64_t release_time;
     uint64_t exec_time;
     uint64_t abs_deadline;
+    uint64_t actual_time;  // time it really runs (EDF engine), 0: exec_time
 } job_t;
 
 typedef struct {
@@ -16,9 +18,65 @@ typedef struct {
     uint64_t executed_jobs;
 } red_state_t;
 
+/* Packed (structure-of-arrays) job layout for red_accept_batch(): each field
+   is a contiguous column, so the feasibility check streams through memory */
+typedef struct {
+    size_t n;
+    size_t cap;
+    int *job_id;
+    uint64_t *release_time;
+    uint64_t *exec_time;
+    uint64_t *abs_deadline;
+    uint64_t *actual_time;
+} red_batch_t;
+
+/* Node of the RED ready set: a treap keyed by (abs_deadline, seq) where each
+   node also keeps the total remaining work and the minimum slack of its
+   subtree, so the full RED test, insertion and removal are all O(log n) */
+typedef struct {
+    job_t job;
+    uint64_t seq;        // arrival order, breaks deadline ties (FIFO)
+    uint64_t remaining;  // execution time still to be served
+    int64_t slack;       // abs_deadline - EDF finish time; constant while the CPU is busy
+    uint64_t sum_work;   // remaining work of the subtree
+    int64_t min_slack;   // minimum slack of the subtree
+    int64_t lazy;        // slack delta not yet pushed to the children
+    uint32_t prio;
+    int32_t left;
+    int32_t right;
+} red_node_t;
+
+typedef struct {
+    red_node_t *nodes;   // node pool, linked by index
+    size_t cap;
+    size_t size;
+    int32_t root;
+    int32_t free_list;
+    uint32_t rng;
+
+    job_t *rejq;         // reject queue (FIFO ring), candidates for reclaiming
+    size_t rejq_cap;
+    size_t rejq_head;
+    size_t rejq_size;
+} red_ready_t;
+
 void red_init(red_state_t *s);
 int red_accept(const job_t *j, const red_state_t *s);
 void red_execute(job_t *j, red_state_t *s);
 
+int red_batch_init(red_batch_t *b, size_t cap);
+void red_batch_free(red_batch_t *b);
+int red_batch_pack(red_batch_t *b, const job_t *jobs, size_t n);
+
+int red_ready_init(red_ready_t *r, size_t cap, size_t rejq_cap);
+void red_ready_free(red_ready_t *r);
+int red_ready_admit(red_ready_t *r, const job_t *j, uint64_t seq, uint64_t now, int test);
+red_node_t *red_ready_min(red_ready_t *r);
+void red_ready_consume(red_ready_t *r, uint64_t dt);
+void red_ready_pop_min(red_ready_t *r);
+void red_ready_shift(red_ready_t *r, uint64_t dt);
+void red_ready_reject(red_ready_t *r, const job_t *j);
+int red_ready_reclaim(red_ready_t *r, uint64_t seq, uint64_t now, size_t *dropped);
+
 #endif
 
@@ -0,0 +1,386 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "red.h"
+#include "edf.h"
+#include "admit_proto.h"
+
+/*
+ * Serviço de controle de admissão: recebe descritores de jobs (admit_proto.h)
+ * por um socket Unix, ou pela entrada padrão (pipe) para testes, e responde
+ * aceita/rejeita com a política RED ou JAMS, mantendo o estado do
+ * escalonador entre as requisições.
+ *
+ * Laço de eventos single-threaded sobre epoll: cada leitura processa todos
+ * os quadros completos do buffer e as respostas saem numa única escrita,
+ * então requisições em pipeline são decididas em lote.
+ */
+
+#define POLICY_RED  0
+#define POLICY_JAMS 1
+
+#define IN_BUF   (64 * 1024)
+#define OUT_BUF  ((IN_BUF / sizeof(admit_req_t) + 1) * sizeof(admit_resp_t))
+#define MAX_EVENTS 64
+
+typedef struct {
+    int fd_in;
+    int fd_out;
+    unsigned char in[IN_BUF];
+    size_t in_len;
+    unsigned char out[OUT_BUF];
+    size_t out_off;
+    size_t out_len;
+    int eof;              // entrada terminou, falta entregar a saída
+} conn_t;
+
+static edf_sched_t sched;
+static int policy = POLICY_RED;
+static uint64_t capacity = 50000;   // JAMS: capacidade em ticks
+static uint32_t rng = 2463534242u;
+static volatile sig_atomic_t stop = 0;
+
+static uint64_t decisions = 0;
+static uint64_t decide_ns = 0;
+// totais da vida do processo: ADMIT_OP_RESET zera os do escalonador
+static uint64_t accepted = 0;
+static uint64_t rejected = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static double rng_uniform01(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng / 4294967296.0;
+}
+
+/*
+ * JAMS com a carga medida como o trabalho pendente no escalonador: aceita se
+ * couber na capacidade, senão aceita com probabilidade
+ * value / (value + sobrecarga_ms * 10 + 1), como em sim.c.
+ */
+static int jams_admit(const job_t *j, uint16_t value) {
+    if (j->release_time > sched.now)
+        edf_advance(&sched, j->release_time);
+
+    uint64_t load = edf_backlog(&sched);
+    int accepted = load + j->exec_time <= capacity;
+    if (!accepted) {
+        double overload_ms = (load + j->exec_time - capacity) / 1000.0;
+        double prob = value / (value + overload_ms * 10.0 + 1.0);
+        accepted = rng_uniform01() < prob;
+    }
+
+    if (accepted)
+        return edf_release(&sched, j);
+    sched.released++;
+    sched.rejected++;
+    return 0;
+}
+
+static void decide(const admit_req_t *req, admit_resp_t *resp) {
+    resp->seq = req->seq;
+    resp->job_id = req->job_id;
+
+    if (req->op == ADMIT_OP_ADMIT) {
+        job_t j = {req->job_id, req->release_time, req->exec_time, req->abs_deadline, 0};
+        int ok = policy == POLICY_JAMS ? jams_admit(&j, req->value) : edf_release(&sched, &j);
+        resp->verdict = ok ? ADMIT_ACCEPT : ADMIT_REJECT;
+        if (ok)
+            accepted++;
+        else
+            rejected++;
+    } else if (req->op == ADMIT_OP_RESET) {
+        edf_cleanup(&sched);
+        resp->verdict = edf_init(&sched, 1024, policy == POLICY_RED) ? ADMIT_ACCEPT : ADMIT_ERROR;
+    } else {
+        resp->verdict = ADMIT_ERROR;
+    }
+    resp->queued = (uint32_t)sched.ready.size;
+}
+
+/* Decide todos os quadros completos do buffer de entrada */
+static void process(conn_t *c) {
+    size_t n = c->in_len / sizeof(admit_req_t);
+    if (n == 0)
+        return;
+
+    uint64_t t0 = now_ns();
+    const admit_req_t *req = (const admit_req_t *)c->in;
+    admit_resp_t *resp = (admit_resp_t *)(c->out + c->out_len);
+    for (size_t i = 0; i < n; i++)
+        decide(&req[i], &resp[i]);
+    decide_ns += now_ns() - t0;
+    decisions += n;
+
+    c->out_len += n * sizeof(admit_resp_t);
+    size_t used = n * sizeof(admit_req_t);
+    memmove(c->in, c->in + used, c->in_len - used);
+    c->in_len -= used;
+}
+
+/* Escreve o que for possível; retorna -1 em erro, 0 se sobrou saída, 1 se esvaziou */
+static int flush(conn_t *c) {
+    while (c->out_off < c->out_len) {
+        ssize_t w = write(c->fd_out, c->out + c->out_off, c->out_len - c->out_off);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return 0;
+            return -1;
+        }
+        c->out_off += (size_t)w;
+    }
+    c->out_off = c->out_len = 0;
+    return 1;
+}
+
+/*
+ * Back-pressure: com saída pendente a conexão para de ler e espera EPOLLOUT
+ * no descritor de saída. No socket é o mesmo descritor; com -i a entrada
+ * (stdin) sai do epoll e a saída (stdout) entra no lugar até esvaziar.
+ */
+static void wait_output(int ep, conn_t *c, int blocked) {
+    struct epoll_event ev = {.events = blocked ? EPOLLOUT : EPOLLIN, .data.ptr = c};
+    if (c->fd_in == c->fd_out) {
+        epoll_ctl(ep, EPOLL_CTL_MOD, c->fd_in, &ev);
+    } else if (blocked) {
+        epoll_ctl(ep, EPOLL_CTL_DEL, c->fd_in, NULL);
+        epoll_ctl(ep, EPOLL_CTL_ADD, c->fd_out, &ev);
+    } else {
+        epoll_ctl(ep, EPOLL_CTL_DEL, c->fd_out, NULL);
+        epoll_ctl(ep, EPOLL_CTL_ADD, c->fd_in, &ev);
+    }
+}
+
+/*
+ * Lê até esvaziar o descritor (ou encher a saída) e responde. Retorna 0
+ * quando a conexão deve ser fechada.
+ */
+static int serve(int ep, conn_t *c) {
+    if (c->out_len > 0) {
+        // saída pendente: só volta a ler depois de entregá-la
+        int r = flush(c);
+        if (r < 0)
+            return 0;
+        if (r == 0)
+            return 1;
+        if (c->eof)
+            return 0;
+        wait_output(ep, c, 0);
+    }
+
+    for (;;) {
+        ssize_t r = read(c->fd_in, c->in + c->in_len, IN_BUF - c->in_len);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return 0;
+        }
+        if (r == 0) {
+            process(c);
+            if (flush(c) != 0)
+                return 0;
+            c->eof = 1;
+            wait_output(ep, c, 1);
+            return 1;
+        }
+        c->in_len += (size_t)r;
+        process(c);
+
+        int f = flush(c);
+        if (f < 0)
+            return 0;
+        if (f == 0) {
+            // cliente não está lendo: para de ler até a saída esvaziar
+            wait_output(ep, c, 1);
+            break;
+        }
+    }
+    return 1;
+}
+
+static conn_t *conn_new(int fd_in, int fd_out) {
+    conn_t *c = malloc(sizeof(conn_t));
+    if (!c)
+        return NULL;
+    c->fd_in = fd_in;
+    c->fd_out = fd_out;
+    c->in_len = c->out_off = c->out_len = 0;
+    c->eof = 0;
+    return c;
+}
+
+static void set_nonblock(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static int listen_unix(const char *path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        perror("Erro abrindo socket");
+        close(fd);
+        return -1;
+    }
+    set_nonblock(fd);
+    return fd;
+}
+
+void usage(const char *prog) {
+    printf("Uso: %s [-p red|jams] [-c capacidade_ticks] [-r semente] [-s socket | -i]\n", prog);
+    printf("Padrao: politica red, socket %s; -i le as requisicoes da entrada padrao (pipe)\n",
+           ADMIT_DEFAULT_SOCKET);
+}
+
+int main(int argc, char **argv) {
+    const char *path = ADMIT_DEFAULT_SOCKET;
+    int use_stdin = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0) {
+            use_stdin = 1;
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "red") == 0)
+                policy = POLICY_RED;
+            else if (strcmp(argv[i], "jams") == 0)
+                policy = POLICY_JAMS;
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            capacity = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rng = (uint32_t)strtoul(argv[++i], NULL, 10);
+            if (rng == 0)
+                rng = 1;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!edf_init(&sched, 1024, policy == POLICY_RED)) {
+        fprintf(stderr, "Erro de alocacao\n");
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int ep = epoll_create1(0);
+    int lfd = -1;
+    int open_conns = 0;
+    if (ep < 0) {
+        perror("epoll_create1");
+        return 1;
+    }
+
+    if (use_stdin) {
+        conn_t *c = conn_new(STDIN_FILENO, STDOUT_FILENO);
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+        set_nonblock(STDIN_FILENO);
+        set_nonblock(STDOUT_FILENO);
+        if (!c || epoll_ctl(ep, EPOLL_CTL_ADD, STDIN_FILENO, &ev) < 0) {
+            perror("Entrada padrao (use um pipe)");
+            return 1;
+        }
+        open_conns = 1;
+    } else {
+        lfd = listen_unix(path);
+        if (lfd < 0)
+            return 1;
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+        epoll_ctl(ep, EPOLL_CTL_ADD, lfd, &ev);
+        fprintf(stderr, "red_daemon: politica %s, socket %s\n",
+                policy == POLICY_RED ? "RED" : "JAMS", path);
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (!stop && (lfd >= 0 || open_conns > 0)) {
+        int n = epoll_wait(ep, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            conn_t *c = events[i].data.ptr;
+            if (c == NULL) {
+                int fd;
+                while ((fd = accept(lfd, NULL, NULL)) >= 0) {
+                    set_nonblock(fd);
+                    conn_t *nc = conn_new(fd, fd);
+                    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = nc};
+                    if (!nc || epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                        free(nc);
+                        close(fd);
+                        continue;
+                    }
+                    open_conns++;
+                }
+                continue;
+            }
+            if (!serve(ep, c)) {
+                epoll_ctl(ep, EPOLL_CTL_DEL, c->fd_in, NULL);
+                if (c->fd_out != c->fd_in)
+                    epoll_ctl(ep, EPOLL_CTL_DEL, c->fd_out, NULL);
+                if (c->fd_in != STDIN_FILENO)
+                    close(c->fd_in);
+                free(c);
+                open_conns--;
+            }
+        }
+    }
+
+    if (lfd >= 0) {
+        close(lfd);
+        unlink(path);
+    }
+    close(ep);
+
+    fprintf(stderr, "Decisoes: %lu (aceitos: %lu, rejeitados: %lu)\n",
+            decisions, accepted, rejected);
+    fprintf(stderr, "Tempo medio de decisao: %.1f ns\n",
+            decisions ? (double)decide_ns / decisions : 0.0);
+    edf_cleanup(&sched);
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include "red_mc.h"
+#include <stdlib.h>
+#include <string.h>
+
+int red_mc_init(red_mc_t *s, int m, size_t cap, int admission) {
+    if (m < 1)
+        m = 1;
+    if (cap == 0)
+        cap = 1;
+    s->ready = malloc(cap * sizeof(red_mc_job_t));
+    s->scratch = malloc((cap + 1) * sizeof(red_mc_job_t));
+    s->core_used = calloc(m, sizeof(uint8_t));
+    s->busy = calloc(m, sizeof(uint64_t));
+    if (!s->ready || !s->scratch || !s->core_used || !s->busy) {
+        red_mc_cleanup(s);
+        return 0;
+    }
+    s->m = m;
+    s->size = 0;
+    s->cap = cap;
+    s->now = 0;
+    s->admission = admission;
+    s->released = s->accepted = s->rejected = 0;
+    s->completed = s->missed_deadlines = 0;
+    s->preemptions = s->migrations = s->events = 0;
+    return 1;
+}
+
+void red_mc_cleanup(red_mc_t *s) {
+    free(s->ready);
+    free(s->scratch);
+    free(s->core_used);
+    free(s->busy);
+    s->ready = s->scratch = NULL;
+    s->core_used = NULL;
+    s->busy = NULL;
+    s->size = s->cap = 0;
+}
+
+/*
+ * Gives a core to each of the first m ready jobs. A release moves at most one
+ * running job out of the first m (to position m), and completions only shift
+ * jobs forward, so ready[m] is the only job that can hold a core it lost.
+ */
+static void red_mc_dispatch(red_mc_t *s) {
+    size_t m = (size_t)s->m;
+    size_t k = s->size < m ? s->size : m;
+
+    if (s->size > m && s->ready[m].core >= 0) {
+        s->core_used[s->ready[m].core] = 0;
+        s->ready[m].core = -1;
+        s->preemptions++;
+    }
+
+    int c = 0;
+    for (size_t i = 0; i < k; i++) {
+        red_mc_job_t *j = &s->ready[i];
+        if (j->core >= 0)
+            continue;
+        while (s->core_used[c])
+            c++;
+        s->core_used[c] = 1;
+        j->core = c;
+        if (j->last_core >= 0 && j->last_core != c)
+            s->migrations++;
+        j->last_core = c;
+    }
+}
+
+/*
+ * Runs the global EDF schedule up to time t: the first m ready jobs run in
+ * parallel and time jumps from one completion to the next.
+ */
+void red_mc_advance(red_mc_t *s, uint64_t t) {
+    size_t m = (size_t)s->m;
+
+    for (;;) {
+        size_t k = s->size < m ? s->size : m;
+        if (k == 0) {
+            if (s->now < t)
+                s->now = t;
+            break;
+        }
+
+        uint64_t dt = s->ready[0].remaining;
+        for (size_t i = 1; i < k; i++)
+            if (s->ready[i].remaining < dt)
+                dt = s->ready[i].remaining;
+
+        if (s->now + dt > t) {
+            dt = t - s->now;
+            for (size_t i = 0; i < k; i++) {
+                s->ready[i].remaining -= dt;
+                s->busy[s->ready[i].core] += dt;
+            }
+            s->now = t;
+            break;
+        }
+
+        s->now += dt;
+        size_t w = 0;
+        for (size_t i = 0; i < s->size; i++) {
+            red_mc_job_t *j = &s->ready[i];
+            if (i < k) {
+                j->remaining -= dt;
+                s->busy[j->core] += dt;
+                if (j->remaining == 0) {
+                    if (s->now > j->job.abs_deadline)
+                        s->missed_deadlines++;
+                    s->completed++;
+                    s->events++;
+                    s->core_used[j->core] = 0;
+                    continue;
+                }
+            }
+            if (w != i)
+                s->ready[w] = *j;
+            w++;
+        }
+        s->size = w;
+        red_mc_dispatch(s);
+    }
+}
+
+/* Job at position pos of the ready set, with W units of earlier-deadline work */
+static inline int red_mc_fits(const red_mc_t *s, size_t pos, const job_t *j, uint64_t remaining, uint64_t W) {
+    if (s->now + remaining > j->abs_deadline)
+        return 0;
+    if (pos < (size_t)s->m)
+        return 1;
+    return (uint64_t)s->m * (j->abs_deadline - s->now - remaining) >= W;
+}
+
+/*
+ * Sufficient test for global EDF without further releases: a job among the
+ * first m keeps its core until it finishes; any other job only waits while
+ * all m cores serve earlier-deadline work, so it finishes by
+ * now + W(d) / m + remaining, where W(d) is the remaining work ahead of it.
+ * Only the new job and the ones behind it are affected by the insertion.
+ */
+static int red_mc_test_bound(const red_mc_t *s, const job_t *j, size_t p) {
+    uint64_t W = 0;
+    for (size_t i = 0; i < p; i++)
+        W += s->ready[i].remaining;
+
+    if (!red_mc_fits(s, p, j, j->exec_time, W))
+        return 0;
+    W += j->exec_time;
+
+    for (size_t i = p; i < s->size; i++) {
+        const red_mc_job_t *r = &s->ready[i];
+        if (!red_mc_fits(s, i + 1, &r->job, r->remaining, W))
+            return 0;
+        W += r->remaining;
+    }
+    return 1;
+}
+
+/*
+ * Exact test: simulates the global EDF schedule of the ready set plus j,
+ * assuming no further releases, and checks that every job meets its deadline.
+ */
+static int red_mc_test_exact(red_mc_t *s, const job_t *j, size_t p) {
+    red_mc_job_t *q = s->scratch;
+    size_t n = s->size + 1;
+    size_t m = (size_t)s->m;
+    uint64_t t = s->now;
+
+    memcpy(q, s->ready, p * sizeof(red_mc_job_t));
+    q[p].job = *j;
+    q[p].remaining = j->exec_time;
+    memcpy(q + p + 1, s->ready + p, (s->size - p) * sizeof(red_mc_job_t));
+
+    for (size_t i = 0; i < n; i++)
+        if (t + q[i].remaining > q[i].job.abs_deadline)
+            return 0;
+
+    while (n > 0) {
+        size_t k = n < m ? n : m;
+        uint64_t dt = q[0].remaining;
+        for (size_t i = 1; i < k; i++)
+            if (q[i].remaining < dt)
+                dt = q[i].remaining;
+
+        t += dt;
+        size_t w = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (i < k) {
+                q[i].remaining -= dt;
+                if (q[i].remaining == 0)
+                    continue;
+            } else if (t + q[i].remaining > q[i].job.abs_deadline) {
+                return 0;
+            }
+            if (w != i)
+                q[w] = q[i];
+            w++;
+        }
+        n = w;
+    }
+    return 1;
+}
+
+/*
+ * Releases job j at max(now, release_time): runs the admission test and
+ * inserts it into the ready set. Returns 1 if the job was accepted.
+ */
+int red_mc_release(red_mc_t *s, const job_t *j) {
+    if (j->release_time > s->now)
+        red_mc_advance(s, j->release_time);
+    s->released++;
+    s->events++;
+
+    // first position with a later deadline (ties keep arrival order)
+    size_t lo = 0, hi = s->size;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (s->ready[mid].job.abs_deadline <= j->abs_deadline)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    int ok = 1;
+    if (s->admission == RED_MC_BOUND)
+        ok = red_mc_test_bound(s, j, lo);
+    else if (s->admission == RED_MC_EXACT)
+        ok = red_mc_test_exact(s, j, lo);
+
+    if (ok && s->size == s->cap) {
+        size_t cap = s->cap * 2;
+        red_mc_job_t *tmp = realloc(s->ready, cap * sizeof(red_mc_job_t));
+        if (tmp)
+            s->ready = tmp;
+        red_mc_job_t *tmp2 = tmp ? realloc(s->scratch, (cap + 1) * sizeof(red_mc_job_t)) : NULL;
+        if (tmp2) {
+            s->scratch = tmp2;
+            s->cap = cap;
+        } else {
+            ok = 0;
+        }
+    }
+    if (!ok) {
+        s->rejected++;
+        return 0;
+    }
+
+    memmove(s->ready + lo + 1, s->ready + lo, (s->size - lo) * sizeof(red_mc_job_t));
+    red_mc_job_t *r = &s->ready[lo];
+    r->job = *j;
+    r->seq = s->released;
+    r->remaining = j->exec_time;
+    r->core = r->last_core = -1;
+    s->size++;
+    s->accepted++;
+
+    red_mc_dispatch(s);
+    return 1;
+}
+
+/* Runs the schedule until the ready set is empty */
+void red_mc_drain(red_mc_t *s) {
+    while (s->size > 0) {
+        uint64_t dt = s->ready[0].remaining;
+        size_t k = s->size < (size_t)s->m ? s->size : (size_t)s->m;
+        for (size_t i = 1; i < k; i++)
+            if (s->ready[i].remaining < dt)
+                dt = s->ready[i].remaining;
+        red_mc_advance(s, s->now + dt);
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef RED_MC_H
+#define RED_MC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "red.h"
+
+/* Admission tests of the multicore scheduler */
+#define RED_MC_NONE  0   // plain global EDF
+#define RED_MC_BOUND 1   // sufficient bound, O(n) per release
+#define RED_MC_EXACT 2   // simulates the global EDF schedule of the ready set
+
+typedef struct {
+    job_t job;
+    uint64_t seq;        // arrival order, breaks deadline ties (FIFO)
+    uint64_t remaining;
+    int core;            // core running the job, -1 if waiting
+    int last_core;       // last core that served the job, -1 if never started
+} red_mc_job_t;
+
+/*
+ * Global EDF on m identical cores: one shared ready set ordered by
+ * (abs_deadline, seq), where the first m jobs hold the cores.
+ */
+typedef struct {
+    int m;
+    red_mc_job_t *ready;
+    size_t size;
+    size_t cap;
+    red_mc_job_t *scratch; // working copy for RED_MC_EXACT (same capacity)
+    uint8_t *core_used;  // 1 if the core runs a job
+    uint64_t *busy;      // busy time of each core
+    uint64_t now;
+    int admission;
+
+    uint64_t released;
+    uint64_t accepted;
+    uint64_t rejected;
+    uint64_t completed;
+    uint64_t missed_deadlines;
+    uint64_t preemptions;
+    uint64_t migrations;
+    uint64_t events;     // releases + completions
+} red_mc_t;
+
+int red_mc_init(red_mc_t *s, int m, size_t cap, int admission);
+void red_mc_cleanup(red_mc_t *s);
+void red_mc_advance(red_mc_t *s, uint64_t t);
+int red_mc_release(red_mc_t *s, const job_t *j);
+void red_mc_drain(red_mc_t *s);
+
+#endif
@@ -3,6 +3,7 @@
 #include <time.h>
 #include <math.h>
 #include <string.h>
+#include "trace.h"
 
 #define NUM_TASKS 20
 #define MAX_CAPACITY 50
@@ -73,6 +74,31 @@ int load_tasks_from_csv(const char *filename, Task tasks[], int max_tasks) {
     return count;
 }
 
+/* Mesmo modelo do CSV, lendo o tempo de execução do trace binário (.rtb) */
+int load_tasks_from_rtb(const char *filename, Task tasks[], int max_tasks) {
+    rtb_trace_t trace;
+    rtb_iter_t it;
+    job_t job;
+    int count = 0;
+
+    if (!rtb_open(&trace, filename))
+        return 0;
+    rtb_iter_init(&it, &trace);
+
+    while (count < max_tasks && rtb_next(&it, &job)) {
+        double C_ms = job.exec_time * (double)trace.hdr->tick_ns / 1e6;
+
+        tasks[count].id = count + 1;
+        tasks[count].computation_time = (int)C_ms;
+        tasks[count].deadline = (int)(5 * C_ms);
+        tasks[count].value = rand() % 100;
+        count++;
+    }
+
+    rtb_close(&trace);
+    return count;
+}
+
 Result simulate_RED(Task tasks[], int n) {
     Result res = {0,0,0,0};
     int current_load = 0;
@@ -126,19 +152,25 @@ void print_ascii_bar(const char* label, double value, int max_scale){
     printf(" %.2f ms\n", value);
 }
 
-int main(){
+int main(int argc, char **argv){
+    const char *path = argc > 1 ? argv[1] : "MPC_times/MPC_long_10/saved_times_long_0.csv";
     srand(time(NULL));
     Task tasks[NUM_TASKS];
 
     double red_resp_sum = 0, jams_resp_sum = 0;
     int red_acc_sum = 0, jams_acc_sum = 0;
 
+    // o trace é lido uma única vez; cada rodada só sorteia novos values
+    int n = rtb_is_binary(path) ? load_tasks_from_rtb(path, tasks, NUM_TASKS)
+                                : load_tasks_from_csv(path, tasks, NUM_TASKS);
+
+    printf("Carregadas %d tarefas reais de %s.\n", n, path);
+
     for(int run=0; run<NUM_RUNS; run++){
         // generate_tasks(tasks, NUM_TASKS);
-        int n = load_tasks_from_csv("MPC_times/MPC_long_10/saved_times_long_0.csv",
-                             tasks, NUM_TASKS);
-
-        printf("Carregadas %d tarefas reais do CSV.\n", n);
+        if (run > 0)
+            for (int i = 0; i < n; i++)
+                tasks[i].value = rand() % 100;
 
         Result r_red = simulate_RED(tasks, NUM_TASKS);
         Result r_jams = simulate_JAMS(tasks, NUM_TASKS);
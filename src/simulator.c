@@ -1,41 +1,183 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "red.h"
 #include "parser.h"
+#include "edf.h"
+#include "trace.h"
+#include "red_mc.h"
+
+static edf_sched_t sched;
+static red_mc_t mc;
+static int cores = 0;     // 0: engine de um processador (edf.c)
+
+// -b: jobs liberados em lotes via red_accept_batch()
+static size_t burst_size = 0;
+static size_t burst_n = 0;
+static job_t *burst;
+static red_batch_t batch;
+static uint8_t *burst_mask;
+
+static void flush_burst(void) {
+    if (burst_n == 0)
+        return;
+    red_batch_pack(&batch, burst, burst_n);
+    red_accept_batch(&batch, burst_n, &sched, burst_mask);
+    burst_n = 0;
+}
+
+static void release_job(const job_t *job) {
+    if (cores > 0) {
+        red_mc_release(&mc, job);
+    } else if (burst_size > 0) {
+        burst[burst_n++] = *job;
+        if (burst_n == burst_size)
+            flush_burst();
+    } else {
+        edf_release(&sched, job);
+    }
+}
 
 int main(int argc, char **argv) {
-    if (argc < 2) {
-        printf("Uso: ./red_sim trace.csv\n");
-        return 1;
+    int admission = 1;
+    int exact = 0;
+
+    while (argc >= 2 && argv[1][0] == '-') {
+        if (strcmp(argv[1], "-e") == 0) {
+            // EDF puro, sem teste de aceitação
+            admission = 0;
+        } else if (strcmp(argv[1], "-x") == 0) {
+            // multicore: teste exato por simulação em vez do limite suficiente
+            exact = 1;
+        } else if (strcmp(argv[1], "-b") == 0 && argc >= 3) {
+            int n = atoi(argv[2]);
+            if (n < 1) {
+                fprintf(stderr, "Tamanho de lote invalido: %s\n", argv[2]);
+                return 1;
+            }
+            burst_size = n;
+            argc--;
+            argv++;
+        } else if (strcmp(argv[1], "-m") == 0 && argc >= 3) {
+            cores = atoi(argv[2]);
+            if (cores < 1) {
+                fprintf(stderr, "Numero de nucleos invalido: %s\n", argv[2]);
+                return 1;
+            }
+            argc--;
+            argv++;
+        } else {
+            break;
+        }
+        argc--;
+        argv++;
     }
 
-    FILE *f = fopen(argv[1], "r");
-    if (!f) {
-        perror("Erro abrindo trace");
+    if (argc < 2 || (exact && cores == 0) || (burst_size > 0 && cores > 0)) {
+        // -x só existe no multicore e -b só no engine de um processador
+        printf("Uso: ./red_sim [-e] [-b lote | -m nucleos [-x]] trace.csv|trace.rtb\n");
         return 1;
     }
 
-    char line[256];
     job_t job;
-    red_state_t state;
-    red_init(&state);
+    int ok;
+    if (cores > 0)
+        ok = red_mc_init(&mc, cores, 1024, admission ? (exact ? RED_MC_EXACT : RED_MC_BOUND) : RED_MC_NONE);
+    else
+        ok = edf_init(&sched, 1024, admission);
+    if (ok && burst_size > 0) {
+        burst = malloc(burst_size * sizeof(job_t));
+        burst_mask = malloc(burst_size);
+        ok = burst && burst_mask && red_batch_init(&batch, burst_size);
+    }
+    if (!ok) {
+        fprintf(stderr, "Erro de alocacao\n");
+        return 1;
+    }
 
-    while (fgets(line, sizeof(line), f)) {
-        if (!parse_job(line, &job))
-            continue;
+    struct timespec ts_beg, ts_end;
+    clock_gettime(CLOCK_MONOTONIC, &ts_beg);
 
-        state.now = job.release_time;
+    if (rtb_is_binary(argv[1])) {
+        rtb_trace_t trace;
+        rtb_iter_t it;
+        if (!rtb_open(&trace, argv[1]))
+            goto fail;
+        rtb_iter_init(&it, &trace);
+        while (rtb_next(&it, &job))
+            release_job(&job);
+        rtb_close(&trace);
+    } else {
+        FILE *f = fopen(argv[1], "r");
+        if (!f) {
+            perror("Erro abrindo trace");
+            goto fail;
+        }
 
-        if (red_accept(&job, &state)) {
-            red_execute(&job, &state);
+        char line[256];
+        while (fgets(line, sizeof(line), f)) {
+            if (!parse_job(line, &job))
+                continue;
+
+            release_job(&job);
         }
+        fclose(f);
+    }
+    if (cores > 0) {
+        red_mc_drain(&mc);
+    } else {
+        flush_burst();
+        edf_drain(&sched);
     }
 
-    fclose(f);
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
 
-    printf("Jobs executados: %lu\n", state.executed_jobs);
-    printf("Deadlines perdidos: %lu\n", state.missed_deadlines);
+    double elapsed_s = (ts_end.tv_sec - ts_beg.tv_sec) + (ts_end.tv_nsec - ts_beg.tv_nsec) / 1e9;
 
+    if (cores > 0) {
+        printf("Nucleos: %d (teste: %s)\n", cores,
+               mc.admission == RED_MC_EXACT ? "exato" : mc.admission == RED_MC_BOUND ? "limite" : "nenhum");
+        printf("Jobs executados: %lu\n", mc.completed);
+        printf("Deadlines perdidos: %lu\n", mc.missed_deadlines);
+        printf("Jobs aceitos: %lu\n", mc.accepted);
+        printf("Jobs rejeitados: %lu\n", mc.rejected);
+        printf("Taxa de aceitacao: %.4f\n", mc.released ? (double)mc.accepted / mc.released : 0.0);
+        printf("Preempcoes: %lu\n", mc.preemptions);
+        printf("Migracoes: %lu\n", mc.migrations);
+        for (int c = 0; c < cores; c++)
+            printf("Utilizacao do nucleo %d: %.4f\n", c, mc.now ? (double)mc.busy[c] / mc.now : 0.0);
+        printf("Eventos: %lu (%.2f M eventos/s)\n", mc.events,
+               elapsed_s > 0 ? mc.events / elapsed_s / 1e6 : 0.0);
+        red_mc_cleanup(&mc);
+        return 0;
+    }
+
+    printf("Jobs executados: %lu\n", sched.completed);
+    printf("Deadlines perdidos: %lu\n", sched.missed_deadlines);
+    printf("Jobs aceitos: %lu\n", sched.accepted);
+    printf("Jobs rejeitados: %lu\n", sched.rejected);
+    printf("Jobs recuperados: %lu (expirados na fila de rejeitados: %zu)\n", sched.reclaimed, sched.reject_dropped);
+    printf("Preempcoes: %lu\n", sched.preemptions);
+    printf("Tempo ocioso: %lu\n", sched.idle_time);
+    printf("Eventos: %lu (%.2f M eventos/s)\n", sched.events,
+           elapsed_s > 0 ? sched.events / elapsed_s / 1e6 : 0.0);
+    printf("Custo por job: %.1f ns (%s)\n", sched.released ? elapsed_s * 1e9 / sched.released : 0.0,
+           burst_size > 0 ? "red_accept_batch" : "edf_release");
+
+    edf_cleanup(&sched);
+    red_batch_free(&batch);
+    free(burst);
+    free(burst_mask);
     return 0;
-}
 
+fail:
+    if (cores > 0)
+        red_mc_cleanup(&mc);
+    else
+        edf_cleanup(&sched);
+    red_batch_free(&batch);
+    free(burst);
+    free(burst_mask);
+    return 1;
+}
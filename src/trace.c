@@ -0,0 +1,212 @@
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* True if the file starts with the binary trace magic */
+int rtb_is_binary(const char *path) {
+    char magic[8];
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    int ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic)
+        && memcmp(magic, RTB_MAGIC, sizeof(magic)) == 0;
+    fclose(f);
+    return ok;
+}
+
+static int rtb_column_ok(const rtb_trace_t *t, uint64_t off, size_t elem) {
+    uint64_t n = t->hdr->num_jobs;
+    return off % 8 == 0 && off <= t->len && n <= (t->len - off) / elem;
+}
+
+int rtb_open(rtb_trace_t *t, const char *path) {
+    struct stat st;
+
+    t->map = MAP_FAILED;
+    t->fd = open(path, O_RDONLY);
+    if (t->fd < 0) {
+        perror("Erro abrindo trace binario");
+        return 0;
+    }
+    if (fstat(t->fd, &st) < 0 || (size_t)st.st_size < sizeof(rtb_header_t)) {
+        fprintf(stderr, "Trace binario invalido: %s\n", path);
+        close(t->fd);
+        return 0;
+    }
+    t->len = st.st_size;
+    t->map = mmap(NULL, t->len, PROT_READ, MAP_PRIVATE, t->fd, 0);
+    if (t->map == MAP_FAILED) {
+        perror("Erro mapeando trace binario");
+        close(t->fd);
+        return 0;
+    }
+    madvise(t->map, t->len, MADV_SEQUENTIAL);
+
+    t->hdr = t->map;
+    if (memcmp(t->hdr->magic, RTB_MAGIC, sizeof(t->hdr->magic)) != 0
+        || t->hdr->version != RTB_VERSION
+        || t->hdr->header_size != sizeof(rtb_header_t)
+        || !rtb_column_ok(t, t->hdr->id_off, sizeof(int32_t))
+        || !rtb_column_ok(t, t->hdr->release_off, sizeof(uint32_t))
+        || !rtb_column_ok(t, t->hdr->exec_off, sizeof(uint64_t))
+        || !rtb_column_ok(t, t->hdr->deadline_off, sizeof(uint64_t))
+        || (t->hdr->flags & ~RTB_FLAG_ACTUAL) != 0
+        || ((t->hdr->flags & RTB_FLAG_ACTUAL)
+            && !rtb_column_ok(t, t->hdr->actual_off, sizeof(uint64_t)))) {
+        fprintf(stderr, "Trace binario invalido ou de versao diferente de %d: %s\n", RTB_VERSION, path);
+        rtb_close(t);
+        return 0;
+    }
+
+    const char *base = t->map;
+    t->job_id = (const int32_t *)(base + t->hdr->id_off);
+    t->release_delta = (const uint32_t *)(base + t->hdr->release_off);
+    t->exec = (const uint64_t *)(base + t->hdr->exec_off);
+    t->rel_deadline = (const uint64_t *)(base + t->hdr->deadline_off);
+    t->actual = (t->hdr->flags & RTB_FLAG_ACTUAL)
+        ? (const uint64_t *)(base + t->hdr->actual_off) : NULL;
+    return 1;
+}
+
+void rtb_close(rtb_trace_t *t) {
+    if (t->map != MAP_FAILED)
+        munmap(t->map, t->len);
+    close(t->fd);
+    t->map = MAP_FAILED;
+}
+
+void rtb_iter_init(rtb_iter_t *it, const rtb_trace_t *t) {
+    it->t = t;
+    it->i = 0;
+    it->release = t->hdr->first_release;
+}
+
+/* Decodes the next job; returns 0 at the end of the trace */
+int rtb_next(rtb_iter_t *it, job_t *j) {
+    const rtb_trace_t *t = it->t;
+    if (it->i >= t->hdr->num_jobs)
+        return 0;
+
+    uint64_t i = it->i++;
+    it->release += t->release_delta[i];
+    j->job_id = t->job_id[i];
+    j->release_time = it->release;
+    j->exec_time = t->exec[i];
+    j->abs_deadline = it->release + t->rel_deadline[i];
+    j->actual_time = t->actual ? t->actual[i] : 0;
+    return 1;
+}
+
+int rtb_writer_init(rtb_writer_t *w, uint32_t tick_ns) {
+    memset(w, 0, sizeof(*w));
+    memcpy(w->hdr.magic, RTB_MAGIC, sizeof(w->hdr.magic));
+    w->hdr.version = RTB_VERSION;
+    w->hdr.header_size = sizeof(rtb_header_t);
+    w->hdr.tick_ns = tick_ns;
+    return 1;
+}
+
+/* Appends a job; releases must be non-decreasing and 32-bit deltas apart */
+int rtb_writer_add(rtb_writer_t *w, const job_t *j) {
+    uint64_t n = w->hdr.num_jobs;
+
+    if (n == 0) {
+        w->hdr.first_release = j->release_time;
+        w->last_release = j->release_time;
+    }
+    if (j->release_time < w->last_release) {
+        fprintf(stderr, "Job %d fora de ordem de release\n", j->job_id);
+        return 0;
+    }
+    if (j->release_time - w->last_release > UINT32_MAX) {
+        fprintf(stderr, "Job %d: intervalo entre releases maior que 32 bits\n", j->job_id);
+        return 0;
+    }
+    if (j->abs_deadline < j->release_time) {
+        fprintf(stderr, "Job %d: deadline anterior ao release\n", j->job_id);
+        return 0;
+    }
+
+    if (n == w->cap) {
+        size_t cap = w->cap ? w->cap * 2 : 4096;
+        int32_t *id = realloc(w->job_id, cap * sizeof(*id));
+        if (id) w->job_id = id;
+        uint32_t *rel = realloc(w->release_delta, cap * sizeof(*rel));
+        if (rel) w->release_delta = rel;
+        uint64_t *exec = realloc(w->exec, cap * sizeof(*exec));
+        if (exec) w->exec = exec;
+        uint64_t *dl = realloc(w->rel_deadline, cap * sizeof(*dl));
+        if (dl) w->rel_deadline = dl;
+        uint64_t *act = realloc(w->actual, cap * sizeof(*act));
+        if (act) w->actual = act;
+        if (!id || !rel || !exec || !dl || !act) {
+            fprintf(stderr, "Erro de alocacao\n");
+            return 0;
+        }
+        w->cap = cap;
+    }
+
+    w->job_id[n] = j->job_id;
+    w->release_delta[n] = (uint32_t)(j->release_time - w->last_release);
+    w->exec[n] = j->exec_time;
+    w->rel_deadline[n] = j->abs_deadline - j->release_time;
+    w->actual[n] = j->actual_time;
+    if (j->actual_time != 0)
+        w->hdr.flags |= RTB_FLAG_ACTUAL;
+    w->last_release = j->release_time;
+    w->hdr.num_jobs++;
+    return 1;
+}
+
+static uint64_t rtb_align8(uint64_t off) {
+    return (off + 7) & ~(uint64_t)7;
+}
+
+int rtb_writer_save(rtb_writer_t *w, const char *path) {
+    uint64_t n = w->hdr.num_jobs;
+    w->hdr.id_off = sizeof(rtb_header_t);
+    w->hdr.release_off = rtb_align8(w->hdr.id_off + n * sizeof(int32_t));
+    w->hdr.exec_off = rtb_align8(w->hdr.release_off + n * sizeof(uint32_t));
+    w->hdr.deadline_off = w->hdr.exec_off + n * sizeof(uint64_t);
+    /* the actual column is only written when some job has one */
+    int actual = (w->hdr.flags & RTB_FLAG_ACTUAL) != 0;
+    w->hdr.actual_off = actual ? w->hdr.deadline_off + n * sizeof(uint64_t) : 0;
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror("Erro criando trace binario");
+        return 0;
+    }
+
+    static const char zeros[8];
+    int ok = fwrite(&w->hdr, sizeof(w->hdr), 1, f) == 1
+        && fwrite(w->job_id, sizeof(int32_t), n, f) == n
+        && fwrite(zeros, 1, w->hdr.release_off - (w->hdr.id_off + n * sizeof(int32_t)), f)
+            == w->hdr.release_off - (w->hdr.id_off + n * sizeof(int32_t))
+        && fwrite(w->release_delta, sizeof(uint32_t), n, f) == n
+        && fwrite(zeros, 1, w->hdr.exec_off - (w->hdr.release_off + n * sizeof(uint32_t)), f)
+            == w->hdr.exec_off - (w->hdr.release_off + n * sizeof(uint32_t))
+        && fwrite(w->exec, sizeof(uint64_t), n, f) == n
+        && fwrite(w->rel_deadline, sizeof(uint64_t), n, f) == n
+        && (!actual || fwrite(w->actual, sizeof(uint64_t), n, f) == n);
+
+    if (fclose(f) != 0)
+        ok = 0;
+    if (!ok)
+        fprintf(stderr, "Erro escrevendo %s\n", path);
+    return ok;
+}
+
+void rtb_writer_free(rtb_writer_t *w) {
+    free(w->job_id);
+    free(w->release_delta);
+    free(w->exec);
+    free(w->rel_deadline);
+    free(w->actual);
+    memset(w, 0, sizeof(*w));
+}
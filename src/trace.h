@@ -0,0 +1,84 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "red.h"
+
+/*
+ * Binary trace format (.rtb), little-endian, version 2:
+ *
+ *   rtb_header_t (80 bytes)
+ *   int32_t  job_id[num_jobs]
+ *   uint32_t release_delta[num_jobs]   release[i] - release[i-1] (release[-1] = first_release)
+ *   uint64_t exec[num_jobs]
+ *   uint64_t rel_deadline[num_jobs]    abs_deadline - release
+ *   uint64_t actual[num_jobs]          only with RTB_FLAG_ACTUAL (CSV 5th column)
+ *
+ * Times are in ticks of tick_ns nanoseconds. Each column starts at the offset
+ * given in the header (8-byte aligned), so the reader maps the file and uses
+ * the columns in place.
+ */
+
+#define RTB_MAGIC "REDTRC\0"
+#define RTB_VERSION 2
+
+#define RTB_FLAG_ACTUAL 0x1  /* actual column present, actual_off valid */
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t num_jobs;
+    uint64_t first_release;
+    uint32_t tick_ns;
+    uint32_t flags;
+    uint64_t id_off;
+    uint64_t release_off;
+    uint64_t exec_off;
+    uint64_t deadline_off;
+    uint64_t actual_off;
+} rtb_header_t;
+
+typedef struct {
+    int fd;
+    void *map;
+    size_t len;
+    const rtb_header_t *hdr;
+    const int32_t *job_id;
+    const uint32_t *release_delta;
+    const uint64_t *exec;
+    const uint64_t *rel_deadline;
+    const uint64_t *actual;  /* NULL without RTB_FLAG_ACTUAL */
+} rtb_trace_t;
+
+typedef struct {
+    const rtb_trace_t *t;
+    uint64_t i;
+    uint64_t release;
+} rtb_iter_t;
+
+int rtb_is_binary(const char *path);
+int rtb_open(rtb_trace_t *t, const char *path);
+void rtb_close(rtb_trace_t *t);
+void rtb_iter_init(rtb_iter_t *it, const rtb_trace_t *t);
+int rtb_next(rtb_iter_t *it, job_t *j);
+
+/* Writer used by the converter: columns are filled in memory, then written */
+typedef struct {
+    rtb_header_t hdr;
+    size_t cap;
+    int32_t *job_id;
+    uint32_t *release_delta;
+    uint64_t *exec;
+    uint64_t *rel_deadline;
+    uint64_t *actual;
+    uint64_t last_release;
+} rtb_writer_t;
+
+int rtb_writer_init(rtb_writer_t *w, uint32_t tick_ns);
+int rtb_writer_add(rtb_writer_t *w, const job_t *j);
+int rtb_writer_save(rtb_writer_t *w, const char *path);
+void rtb_writer_free(rtb_writer_t *w);
+
+#endif
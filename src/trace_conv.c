@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "red.h"
+#include "parser.h"
+#include "trace.h"
+
+/*
+ * Converte um trace CSV para o formato binário (.rtb).
+ *
+ * Layouts aceitos (detectados por linha, cabeçalhos são ignorados):
+ *   job_id,release,exec,deadline   (tempos em ticks; um 5º campo, actual,
+ *                                   vai para a coluna opcional do .rtb)
+ *   index,segundos                 (MPC_times: tempo de execução em segundos;
+ *                                   release = index * periodo,
+ *                                   deadline = release + deadline relativo)
+ */
+void usage(const char *prog) {
+    printf("Uso: %s [-t tick_ns] [-p periodo_ticks] [-d deadline_rel_ticks] entrada.csv saida.rtb\n", prog);
+    printf("Padrao: tick de 1000 ns (us), periodo 100000 ticks, deadline relativo = periodo\n");
+}
+
+int main(int argc, char **argv) {
+    uint32_t tick_ns = 1000;
+    uint64_t period = 100000;
+    uint64_t rel_deadline = 0;
+    int i;
+
+    for (i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        if (strcmp(argv[i], "-t") == 0)
+            tick_ns = strtoul(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-p") == 0)
+            period = strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-d") == 0)
+            rel_deadline = strtoull(argv[i + 1], NULL, 10);
+        else
+            break;
+    }
+    if (argc - i != 2 || tick_ns == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (rel_deadline == 0)
+        rel_deadline = period;
+
+    FILE *f = fopen(argv[i], "r");
+    if (!f) {
+        perror("Erro abrindo trace");
+        return 1;
+    }
+
+    rtb_writer_t w;
+    rtb_writer_init(&w, tick_ns);
+
+    char line[256];
+    job_t job;
+    long index;
+    double seconds;
+    int ok = 1, mpc = 0;
+
+    while (ok && fgets(line, sizeof(line), f)) {
+        if (parse_job(line, &job)) {
+            ok = rtb_writer_add(&w, &job);
+        } else if (sscanf(line, "%ld,%lf", &index, &seconds) == 2 && index >= 0 && seconds >= 0) {
+            job.job_id = (int)index;
+            job.release_time = (uint64_t)index * period;
+            job.exec_time = (uint64_t)llround(seconds * 1e9 / tick_ns);
+            job.abs_deadline = job.release_time + rel_deadline;
+            job.actual_time = 0;
+            ok = rtb_writer_add(&w, &job);
+            mpc = 1;
+        }
+    }
+    fclose(f);
+
+    if (ok)
+        ok = rtb_writer_save(&w, argv[i + 1]);
+    if (ok)
+        printf("%s -> %s: %lu jobs (%s%s), tick %u ns\n", argv[i], argv[i + 1],
+               (unsigned long)w.hdr.num_jobs, mpc ? "MPC index,segundos" : "job_id,release,exec,deadline",
+               (w.hdr.flags & RTB_FLAG_ACTUAL) ? ",actual" : "", tick_ns);
+
+    rtb_writer_free(&w);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+#include "stats.h"
+#include <math.h>
+#include <string.h>
+
+static const double stats_quantiles[STATS_NUM_QUANTILES] = { 0.50, 0.90, 0.99, 0.999 };
+
+static void p2_init(P2Quantile *q, double p) {
+    q->p = p;
+    q->count = 0;
+    for (int i = 0; i < 5; ++i) q->pos[i] = i + 1;
+    q->want[0] = 1;
+    q->want[1] = 1 + 2 * p;
+    q->want[2] = 1 + 4 * p;
+    q->want[3] = 3 + 2 * p;
+    q->want[4] = 5;
+    q->inc[0] = 0;
+    q->inc[1] = p / 2;
+    q->inc[2] = p;
+    q->inc[3] = (1 + p) / 2;
+    q->inc[4] = 1;
+}
+
+static double p2_parabolic(const P2Quantile *q, int i, int d) {
+    return q->h[i] + d / (q->pos[i + 1] - q->pos[i - 1]) *
+        ((q->pos[i] - q->pos[i - 1] + d) * (q->h[i + 1] - q->h[i]) / (q->pos[i + 1] - q->pos[i]) +
+         (q->pos[i + 1] - q->pos[i] - d) * (q->h[i] - q->h[i - 1]) / (q->pos[i] - q->pos[i - 1]));
+}
+
+static double p2_linear(const P2Quantile *q, int i, int d) {
+    return q->h[i] + d * (q->h[i + d] - q->h[i]) / (q->pos[i + d] - q->pos[i]);
+}
+
+static void p2_add(P2Quantile *q, double x) {
+    if (q->count < 5) {
+        // primeiras 5 amostras: insere ordenado
+        int i = (int)q->count++;
+        while (i > 0 && q->h[i - 1] > x) {
+            q->h[i] = q->h[i - 1];
+            i--;
+        }
+        q->h[i] = x;
+        return;
+    }
+    q->count++;
+
+    int k;
+    if (x < q->h[0]) {
+        q->h[0] = x;
+        k = 0;
+    } else if (x >= q->h[4]) {
+        q->h[4] = x;
+        k = 3;
+    } else {
+        for (k = 0; k < 3 && x >= q->h[k + 1]; ++k)
+            ;
+    }
+
+    for (int i = k + 1; i < 5; ++i) q->pos[i] += 1;
+    for (int i = 0; i < 5; ++i) q->want[i] += q->inc[i];
+
+    // ajusta os marcadores centrais
+    for (int i = 1; i <= 3; ++i) {
+        double d = q->want[i] - q->pos[i];
+        if ((d >= 1 && q->pos[i + 1] - q->pos[i] > 1) ||
+            (d <= -1 && q->pos[i - 1] - q->pos[i] < -1)) {
+            int s = d >= 0 ? 1 : -1;
+            double h = p2_parabolic(q, i, s);
+            if (q->h[i - 1] < h && h < q->h[i + 1])
+                q->h[i] = h;
+            else
+                q->h[i] = p2_linear(q, i, s);
+            q->pos[i] += s;
+        }
+    }
+}
+
+static double p2_get(const P2Quantile *q) {
+    if (q->count == 0) return 0.0;
+    if (q->count < 5) {
+        // ainda exato: quantil por vizinho mais próximo das amostras ordenadas
+        int i = (int)ceil(q->p * q->count) - 1;
+        if (i < 0) i = 0;
+        return q->h[i];
+    }
+    return q->h[2];
+}
+
+void stats_init(RunningStats *s) {
+    s->n = 0;
+    s->mean = 0.0;
+    s->m2 = 0.0;
+    s->min = 0.0;
+    s->max = 0.0;
+    for (int i = 0; i < STATS_NUM_QUANTILES; ++i)
+        p2_init(&s->q[i], stats_quantiles[i]);
+}
+
+void stats_add(RunningStats *s, double x) {
+    s->n++;
+    double delta = x - s->mean;
+    s->mean += delta / s->n;
+    s->m2 += delta * (x - s->mean);
+
+    if (s->n == 1 || x < s->min) s->min = x;
+    if (s->n == 1 || x > s->max) s->max = x;
+
+    if (s->n <= STATS_EXACT_MAX) {
+        // insere ordenado
+        long i = s->n - 1;
+        while (i > 0 && s->exact[i - 1] > x) {
+            s->exact[i] = s->exact[i - 1];
+            i--;
+        }
+        s->exact[i] = x;
+    }
+
+    // o P² acompanha desde o início, para assumir quando o buffer encher
+    for (int i = 0; i < STATS_NUM_QUANTILES; ++i)
+        p2_add(&s->q[i], x);
+}
+
+/* Desvio padrão populacional, como em calcula_stats.sh: sqrt(var / n) */
+double stats_std(const RunningStats *s) {
+    return s->n > 0 ? sqrt(s->m2 / s->n) : 0.0;
+}
+
+/*
+ * Meia largura do intervalo de confiança de 95% da média (t de Student com
+ * n - 1 graus de liberdade, normal a partir de 30). Indefinida (NAN) com
+ * menos de 2 amostras, em vez de um 0 que pareceria um intervalo exato.
+ */
+double stats_ci95(const RunningStats *s) {
+    static const double t975[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (s->n < 2) return NAN;
+    double t = s->n - 1 <= 30 ? t975[s->n - 2] : 1.960;
+    return t * sqrt(s->m2 / (s->n - 1)) / sqrt((double)s->n);
+}
+
+double stats_quantile(const RunningStats *s, int i) {
+    if (s->n == 0) return 0.0;
+    if (s->n <= STATS_EXACT_MAX) {
+        // exato: vizinho mais próximo das amostras ordenadas
+        long k = (long)ceil(stats_quantiles[i] * s->n) - 1;
+        if (k < 0) k = 0;
+        return s->exact[k];
+    }
+    // P²: estimativas independentes por quantil podem se cruzar nas caudas
+    double v = s->min;
+    for (int j = 0; j <= i; ++j) {
+        double q = p2_get(&s->q[j]);
+        if (q > v) v = q;
+    }
+    return v > s->max ? s->max : v;
+}
+
+void stats_write_header(FILE *f) {
+    fprintf(f, "algorithm,mean_time,max_time,min_time,std_time,p50_time,p90_time,p99_time,p999_time\n");
+}
+
+void stats_write_row(FILE *f, const char *label, const RunningStats *s) {
+    fprintf(f, "%s,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n",
+            label, s->mean, s->max, s->min, stats_std(s),
+            stats_quantile(s, 0), stats_quantile(s, 1), stats_quantile(s, 2), stats_quantile(s, 3));
+}
+
+static int hist_index(unsigned long long v) {
+    if (v < (1ull << HIST_SUB_BITS))
+        return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - HIST_SUB_BITS;
+    return ((shift + 1) << HIST_SUB_BITS) + (int)((v >> shift) - (1ull << HIST_SUB_BITS));
+}
+
+/* Ponto médio do balde i */
+static double hist_value(int i) {
+    if (i < (1 << HIST_SUB_BITS))
+        return i;
+    int shift = (i >> HIST_SUB_BITS) - 1;
+    unsigned long long low = ((unsigned long long)(i & ((1 << HIST_SUB_BITS) - 1)) + (1ull << HIST_SUB_BITS)) << shift;
+    return low + ((1ull << shift) - 1) / 2.0;
+}
+
+void hist_init(LogHist *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void hist_add(LogHist *h, long x) {
+    if (h->n == 0 || x < h->min) h->min = x;
+    if (h->n == 0 || x > h->max) h->max = x;
+    h->n++;
+    h->sum += x;
+    if (x >= 0)
+        h->pos[hist_index((unsigned long long)x)]++;
+    else
+        h->neg[hist_index(-(unsigned long long)x)]++;
+}
+
+void hist_merge(LogHist *dst, const LogHist *src) {
+    if (src->n == 0)
+        return;
+    if (dst->n == 0 || src->min < dst->min) dst->min = src->min;
+    if (dst->n == 0 || src->max > dst->max) dst->max = src->max;
+    dst->n += src->n;
+    dst->sum += src->sum;
+    for (int i = 0; i < HIST_BUCKETS; ++i) {
+        dst->pos[i] += src->pos[i];
+        dst->neg[i] += src->neg[i];
+    }
+}
+
+double hist_mean(const LogHist *h) {
+    return h->n > 0 ? h->sum / h->n : 0.0;
+}
+
+/* Quantil p (0..1) pelo vizinho mais próximo, limitado a [min, max] */
+double hist_quantile(const LogHist *h, double p) {
+    if (h->n == 0) return 0.0;
+    long rank = (long)ceil(p * h->n);
+    if (rank < 1) rank = 1;
+
+    double v = h->max;
+    long seen = 0;
+    for (int i = HIST_BUCKETS - 1; i >= 0; --i) {
+        seen += h->neg[i];
+        if (seen >= rank) {
+            v = -hist_value(i);
+            goto out;
+        }
+    }
+    for (int i = 0; i < HIST_BUCKETS; ++i) {
+        seen += h->pos[i];
+        if (seen >= rank) {
+            v = hist_value(i);
+            break;
+        }
+    }
+out:
+    if (v < h->min) v = h->min;
+    if (v > h->max) v = h->max;
+    return v;
+}
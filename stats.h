@@ -0,0 +1,72 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+/*
+ * Estatísticas em fluxo (uma passada, memória constante):
+ * média/variância de Welford, mínimo/máximo e quantis P50/P90/P99/P99.9.
+ * Até STATS_EXACT_MAX amostras os quantis são exatos (amostras guardadas
+ * ordenadas); acima disso vêm do algoritmo P² (Jain & Chlamtac, 1985), que
+ * erra muito nas caudas com poucas amostras. Os quantis reportados são
+ * sempre monótonos e ficam em [min, max].
+ */
+
+#define STATS_NUM_QUANTILES 4
+#define STATS_EXACT_MAX 4096
+
+/* Estimador P² de um quantil: 5 marcadores, sem guardar as amostras */
+typedef struct {
+    double p;        // quantil desejado (0..1)
+    double h[5];     // alturas dos marcadores
+    double pos[5];   // posições atuais
+    double want[5];  // posições desejadas
+    double inc[5];   // incremento das posições desejadas
+    long count;
+} P2Quantile;
+
+typedef struct {
+    long n;
+    double mean;
+    double m2;       // soma dos quadrados dos desvios (Welford)
+    double min;
+    double max;
+    P2Quantile q[STATS_NUM_QUANTILES];
+    double exact[STATS_EXACT_MAX];  // amostras ordenadas, enquanto n <= STATS_EXACT_MAX
+} RunningStats;
+
+void stats_init(RunningStats *s);
+void stats_add(RunningStats *s, double x);
+double stats_std(const RunningStats *s);
+double stats_ci95(const RunningStats *s);
+double stats_quantile(const RunningStats *s, int i);
+
+/*
+ * Histograma log-linear de inteiros com sinal (ex.: tempos em us): 2^S
+ * baldes lineares por potência de 2, erro relativo <= 1/2^S em qualquer
+ * quantil. Ao contrário do P², histogramas de várias threads podem ser
+ * somados (hist_merge) sem perder precisão.
+ */
+#define HIST_SUB_BITS 4
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) << HIST_SUB_BITS)
+
+typedef struct {
+    long n;
+    double sum;
+    long min;
+    long max;
+    long pos[HIST_BUCKETS];  // valores >= 0
+    long neg[HIST_BUCKETS];  // valores < 0, pelo módulo
+} LogHist;
+
+void hist_init(LogHist *h);
+void hist_add(LogHist *h, long x);
+void hist_merge(LogHist *dst, const LogHist *src);
+double hist_mean(const LogHist *h);
+double hist_quantile(const LogHist *h, double p);
+
+/* Mesmo esquema de scripts/calcula_stats.sh, mais as colunas de percentis */
+void stats_write_header(FILE *f);
+void stats_write_row(FILE *f, const char *label, const RunningStats *s);
+
+#endif